@@ -0,0 +1,209 @@
+#include "BackgroundTriangulation.h"
+
+BackgroundTriangulation::BackgroundTriangulation() :
+	myState(State::idle),
+	myStop(false),
+	myMemoryUsage(0),
+	myTrace(nullptr),
+	myResuming(false)
+{
+}
+
+BackgroundTriangulation::~BackgroundTriangulation()
+{
+	if (!myThread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(myMutex);
+		myStop = true;
+	}
+	myCondition.notify_all();
+	myThread.join();
+}
+
+BackgroundTriangulation::Job&
+BackgroundTriangulation::getJob()
+{
+	return myJob;
+}
+
+void
+BackgroundTriangulation::start()
+{
+	if (!myThread.joinable()) {
+		myThread = std::thread(&BackgroundTriangulation::threadLoop, this);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(myMutex);
+		myState = State::running;
+		myTrace = CookTrace::getCurrent();
+	}
+	myCondition.notify_all();
+}
+
+void
+BackgroundTriangulation::startSliced()
+{
+	std::lock_guard<std::mutex> lock(myMutex);
+	myState = State::sliced;
+	myResuming = false;
+}
+
+void
+BackgroundTriangulation::resume(std::chrono::steady_clock::time_point deadline)
+{
+	{
+		std::lock_guard<std::mutex> lock(myMutex);
+		if (myState != State::sliced) {
+			return;
+		}
+	}
+
+	// only the sweep hull of all the points can be stopped on the way
+	Job& job = myJob;
+	if (job.partitioned || job.divideAndConquer || !job.needTriangles) {
+		triangulate(job);
+	} else {
+		if (!myResuming) {
+			mySweepHull.begin(job.coords, job.triangulation);
+			myResuming = true;
+		}
+		if (!mySweepHull.resume(deadline)) {
+			return;
+		}
+		myResuming = false;
+		finish(job);
+	}
+
+	std::size_t memoryUsage = computeMemoryUsage();
+	std::lock_guard<std::mutex> lock(myMutex);
+	myMemoryUsage = memoryUsage;
+	myState = State::done;
+}
+
+bool
+BackgroundTriangulation::isRunning() const
+{
+	std::lock_guard<std::mutex> lock(myMutex);
+	return myState == State::running || myState == State::sliced;
+}
+
+bool
+BackgroundTriangulation::isDone() const
+{
+	std::lock_guard<std::mutex> lock(myMutex);
+	return myState == State::done;
+}
+
+void
+BackgroundTriangulation::acceptResult()
+{
+	std::lock_guard<std::mutex> lock(myMutex);
+	if (myState == State::done) {
+		myState = State::idle;
+	}
+}
+
+void
+BackgroundTriangulation::threadLoop()
+{
+	CookTrace::setThreadName("background triangulation");
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(myMutex);
+			myCondition.wait(lock, [this] { return myStop || myState == State::running; });
+			if (myState != State::running) {
+				return;
+			}
+			CookTrace::setCurrent(myTrace);
+		}
+
+		// the job is ours until the state changes
+		{
+			CookTrace::Scope span("background_triangulation");
+			triangulate(myJob);
+		}
+		CookTrace::setCurrent(nullptr);
+		std::size_t memoryUsage = computeMemoryUsage();
+
+		std::lock_guard<std::mutex> lock(myMutex);
+		myMemoryUsage = memoryUsage;
+		myState = State::done;
+	}
+}
+
+void
+BackgroundTriangulation::triangulate(Job& job)
+{
+	myPool.setMaxThreads(job.maxThreads);
+
+	if (!job.needTriangles) {
+		job.triangulation.triangles.clear();
+		job.triangulation.halfedges.clear();
+		job.numSkipped = 0;
+		job.counts = TriangulationCounts();
+		return;
+	}
+
+	if (job.partitioned) {
+		myPartitioned.triangulate(job.coords, job.partitions, job.numPartitions, job.divideAndConquer,
+								  myPool, job.triangulation);
+	} else if (job.divideAndConquer) {
+		myDivideAndConquer.triangulate(job.coords, myPool, job.triangulation);
+	} else {
+		mySweepHull.triangulate(job.coords, job.triangulation);
+	}
+	finish(job);
+}
+
+void
+BackgroundTriangulation::finish(Job& job)
+{
+	job.numSkipped = 0;
+	if (job.constrained) {
+		myConstrained.constrain(job.coords, job.constraintEdges, job.triangulation);
+		job.numSkipped = myConstrained.getNumSkipped();
+	}
+	countTriangulation(job.triangulation, job.coords.size() / 2, myUsedPoints, job.counts);
+}
+
+std::size_t
+BackgroundTriangulation::computeMemoryUsage() const
+{
+	return mySweepHull.getMemoryUsage() + myDivideAndConquer.getMemoryUsage() +
+		myConstrained.getMemoryUsage() + myPartitioned.getMemoryUsage() +
+		myUsedPoints.capacity() * sizeof(uint8_t) +
+		myJob.coords.capacity() * sizeof(float) +
+		myJob.constraintEdges.capacity() * sizeof(int32_t) +
+		myJob.partitions.capacity() * sizeof(uint32_t) +
+		(myJob.triangulation.triangles.capacity() + myJob.triangulation.halfedges.capacity()) * sizeof(std::size_t);
+}
+
+std::size_t
+BackgroundTriangulation::getMemoryUsage() const
+{
+	return myMemoryUsage.load();
+}
+
+void
+BackgroundTriangulation::releaseMemory()
+{
+	std::lock_guard<std::mutex> lock(myMutex);
+	if (myState == State::running || myState == State::sliced) {
+		return;
+	}
+
+	// a result not accepted yet is kept, only the engines let go of their buffers
+	mySweepHull.releaseMemory();
+	myDivideAndConquer.releaseMemory();
+	myConstrained.releaseMemory();
+	myPartitioned.releaseMemory();
+	std::vector<uint8_t>().swap(myUsedPoints);
+	if (myState == State::idle) {
+		myJob = Job();
+	}
+	myMemoryUsage = computeMemoryUsage();
+}
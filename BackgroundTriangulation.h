@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ConstrainedDelaunay.h"
+#include "CookTrace.h"
+#include "DivideAndConquerDelaunay.h"
+#include "PartitionedDelaunay.h"
+#include "SweepHullDelaunay.h"
+#include "ThreadPool.h"
+#include "Triangulation.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Triangulates on a thread of its own, or a slice of every cook, so a cook doesn't
+// have to wait for it. The node fills the job while it is idle and starts it, then
+// keeps showing its previous result until the job is done. The result is taken by swapping buffers
+// with the job, so the buffers of the previous result are reused by the next job.
+// The engines belong to the object, the cook can keep using its own at the same time.
+class BackgroundTriangulation
+{
+public:
+
+	struct Job
+	{
+		// coords holds u0, v0, u1, v1, ...
+		std::vector<float>		coords;
+
+		// when constrained, two point indices per edge forced into the triangulation
+		bool					constrained = false;
+		std::vector<int32_t>	constraintEdges;
+
+		// when partitioned, the partition of every point like for PartitionedDelaunay
+		bool					partitioned = false;
+		std::vector<uint32_t>	partitions;
+		uint32_t				numPartitions = 0;
+
+		bool					divideAndConquer = false;
+
+		// false when only the points are wanted, like for the hull, the triangulation is then left empty
+		bool					needTriangles = true;
+
+		// threads of the pool used by the job, 0 for all
+		unsigned				maxThreads = 0;
+
+		// the result, valid once isDone
+		Triangulation			triangulation;
+		std::size_t				numSkipped = 0;
+		TriangulationCounts		counts;
+	};
+
+	BackgroundTriangulation();
+
+	// waits for the running job, it can't be interrupted
+	~BackgroundTriangulation();
+
+	BackgroundTriangulation(const BackgroundTriangulation&) = delete;
+	BackgroundTriangulation& operator=(const BackgroundTriangulation&) = delete;
+
+	// the job can only be touched while it isn't running
+	Job& getJob();
+
+	// triangulates the job in the background
+	void start();
+
+	// triangulates the job on the calling thread, in the calls to resume
+	void startSliced();
+
+	// carries on a sliced job until it is done or the deadline passed, does nothing
+	// for a job started in the background. Only the sweep hull can stop before the end,
+	// the other engines and the constraints are done in one go.
+	void resume(std::chrono::steady_clock::time_point deadline);
+
+	// a job was started and is not done yet
+	bool isRunning() const;
+
+	// a job is done and its result was not accepted yet
+	bool isDone() const;
+
+	// the result was taken, start can be called again
+	void acceptResult();
+
+	// bytes held by the buffers, as of the end of the last job. Doesn't lock.
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system, does nothing while a job is running
+	void releaseMemory();
+
+private:
+
+	enum State { idle, running, sliced, done };
+
+	void threadLoop();
+
+	void triangulate(Job& job);
+
+	// the triangulation is done, only the constraints are left
+	void finish(Job& job);
+
+	std::size_t computeMemoryUsage() const;
+
+	Job							myJob;
+
+	ThreadPool					myPool;
+	SweepHullDelaunay			mySweepHull;
+	DivideAndConquerDelaunay	myDivideAndConquer;
+	ConstrainedDelaunay			myConstrained;
+	PartitionedDelaunay			myPartitioned;
+	std::vector<uint8_t>		myUsedPoints;
+
+	// the thread starts with the first job
+	std::thread					myThread;
+	mutable std::mutex			myMutex;
+	std::condition_variable		myCondition;
+	State						myState;
+	bool						myStop;
+	// written under the mutex, read without it
+	std::atomic<std::size_t>	myMemoryUsage;
+
+	// the trace of the cook that started the job, it outlives the object
+	CookTrace*					myTrace;
+
+	// a sliced job started the sweep hull
+	bool						myResuming;
+};
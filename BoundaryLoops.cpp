@@ -0,0 +1,84 @@
+#include "BoundaryLoops.h"
+
+namespace
+{
+	inline std::size_t
+	nextHalfedge(std::size_t e)
+	{
+		return (e % 3 == 2) ? e - 2 : e + 1;
+	}
+}
+
+void
+BoundaryLoops::build(const Triangulation& triangulation, const std::vector<uint8_t>& kept)
+{
+	const std::vector<std::size_t>& triangles = triangulation.triangles;
+	const std::vector<std::size_t>& halfedges = triangulation.halfedges;
+	const std::size_t numHalfedges = triangles.size();
+
+	myIndices.clear();
+	mySizes.clear();
+
+	auto isKept = [&](std::size_t triangle) {
+		return kept.empty() || kept[triangle] != 0;
+	};
+	auto isBoundary = [&](std::size_t e) {
+		return isKept(e / 3) && (halfedges[e] == Triangulation::InvalidIndex || !isKept(halfedges[e] / 3));
+	};
+
+	myPending.resize(numHalfedges);
+	for (std::size_t e = 0; e < numHalfedges; e++) {
+		myPending[e] = isBoundary(e);
+	}
+
+	for (std::size_t start = 0; start < numHalfedges; start++) {
+		if (!myPending[start]) {
+			continue;
+		}
+
+		const std::size_t loopStart = myIndices.size();
+		std::size_t e = start;
+		do {
+			myPending[e] = 0;
+			myIndices.push_back(static_cast<int32_t>(triangles[e]));
+
+			// turn around the end point of e through the kept triangles until we
+			// leave them, which is the next boundary edge of the same loop
+			std::size_t next = nextHalfedge(e);
+			while (!isBoundary(next)) {
+				next = nextHalfedge(halfedges[next]);
+			}
+			e = next;
+		} while (e != start);
+
+		myIndices.push_back(myIndices[loopStart]);
+		mySizes.push_back(static_cast<int32_t>(myIndices.size() - loopStart));
+	}
+}
+
+const std::vector<int32_t>&
+BoundaryLoops::getIndices() const
+{
+	return myIndices;
+}
+
+const std::vector<int32_t>&
+BoundaryLoops::getSizes() const
+{
+	return mySizes;
+}
+
+std::size_t
+BoundaryLoops::getMemoryUsage() const
+{
+	return myPending.capacity() * sizeof(uint8_t) +
+		(myIndices.capacity() + mySizes.capacity()) * sizeof(int32_t);
+}
+
+void
+BoundaryLoops::releaseMemory()
+{
+	std::vector<uint8_t>().swap(myPending);
+	std::vector<int32_t>().swap(myIndices);
+	std::vector<int32_t>().swap(mySizes);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Closed outlines of a set of triangles from a triangulation, the outer ones
+// and the ones around the holes. A boundary edge is an edge whose neighbour
+// triangle is missing or was culled, and each loop is followed by turning
+// around its points through the halfedges, so it runs in linear time.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class BoundaryLoops
+{
+public:
+
+	// kept holds one byte per triangle, 0 for the triangles left out. An empty kept
+	// keeps all the triangles, which gives the convex hull.
+	void build(const Triangulation& triangulation, const std::vector<uint8_t>& kept);
+
+	// points of all the loops one after the other, every loop going back to its first point
+	const std::vector<int32_t>& getIndices() const;
+
+	// number of indices of every loop
+	const std::vector<int32_t>& getSizes() const;
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// one byte per halfedge, set for the boundary edges not yet in a loop
+	std::vector<uint8_t>		myPending;
+
+	std::vector<int32_t>		myIndices;
+	std::vector<int32_t>		mySizes;
+};
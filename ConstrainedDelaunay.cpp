@@ -0,0 +1,490 @@
+#include "ConstrainedDelaunay.h"
+#include "Predicates.h"
+
+#include <cstring>
+
+namespace
+{
+	// the halfedge is part of a constraint, it is never flipped
+	const uint8_t ConstraintFlag = 1;
+	// crossing the halfedge toggles inside and outside, constraints given twice cancel out
+	const uint8_t ParityFlag = 2;
+
+	const uint8_t Unvisited = 0xff;
+
+	inline std::size_t
+	nextHalfedge(std::size_t e)
+	{
+		return (e % 3 == 2) ? e - 2 : e + 1;
+	}
+
+	inline std::size_t
+	prevHalfedge(std::size_t e)
+	{
+		return (e % 3 == 0) ? e + 2 : e - 1;
+	}
+}
+
+ConstrainedDelaunay::ConstrainedDelaunay() :
+	myCoords(nullptr),
+	myTriangulation(nullptr),
+	myNumSkipped(0)
+{
+}
+
+std::size_t
+ConstrainedDelaunay::findVertex(std::size_t point)
+{
+	if (myVertexEdge[point] != Triangulation::InvalidIndex) {
+		return point;
+	}
+
+	const std::vector<float>& coords = *myCoords;
+	auto placeKey = [&](std::size_t p) {
+		// adding zero turns -0 into 0, so both have the same bits
+		const float x = coords[2 * p] + 0.0f;
+		const float y = coords[2 * p + 1] + 0.0f;
+		uint32_t xBits, yBits;
+		memcpy(&xBits, &x, sizeof(xBits));
+		memcpy(&yBits, &y, sizeof(yBits));
+		return (static_cast<uint64_t>(xBits) << 32) | yBits;
+	};
+
+	if (myPlaces.empty()) {
+		for (std::size_t p = 0; p < myVertexEdge.size(); p++) {
+			if (myVertexEdge[p] != Triangulation::InvalidIndex) {
+				myPlaces.emplace(placeKey(p), p);
+			}
+		}
+	}
+
+	auto place = myPlaces.find(placeKey(point));
+	return place != myPlaces.end() ? place->second : Triangulation::InvalidIndex;
+}
+
+void
+ConstrainedDelaunay::gatherFan(std::size_t point)
+{
+	const std::vector<std::size_t>& halfedges = myTriangulation->halfedges;
+
+	myFan.clear();
+	const std::size_t start = myVertexEdge[point];
+	std::size_t e = start;
+	do {
+		myFan.push_back(e);
+		const std::size_t incoming = prevHalfedge(e);
+		if (halfedges[incoming] == Triangulation::InvalidIndex) {
+			// the point is on the hull, the rest of the fan is on the other side of start
+			std::size_t back = start;
+			while (halfedges[back] != Triangulation::InvalidIndex) {
+				back = nextHalfedge(halfedges[back]);
+				myFan.push_back(back);
+			}
+			break;
+		}
+		e = halfedges[incoming];
+	} while (e != start);
+}
+
+std::size_t
+ConstrainedDelaunay::findEdge(std::size_t a, std::size_t b)
+{
+	const std::vector<std::size_t>& triangles = myTriangulation->triangles;
+	const std::vector<std::size_t>& halfedges = myTriangulation->halfedges;
+
+	// the edge to the last neighbour of a point on the hull only goes toward the point
+	auto edgeIn = [&](std::size_t e) {
+		if (triangles[nextHalfedge(e)] == b) {
+			return e;
+		}
+		if (triangles[prevHalfedge(e)] == b) {
+			return prevHalfedge(e);
+		}
+		return Triangulation::InvalidIndex;
+	};
+
+	// same walk as gatherFan, stopping as soon as the edge is found
+	const std::size_t start = myVertexEdge[a];
+	std::size_t e = start;
+	do {
+		const std::size_t found = edgeIn(e);
+		if (found != Triangulation::InvalidIndex) {
+			return found;
+		}
+		const std::size_t incoming = prevHalfedge(e);
+		if (halfedges[incoming] == Triangulation::InvalidIndex) {
+			std::size_t back = start;
+			while (halfedges[back] != Triangulation::InvalidIndex) {
+				back = nextHalfedge(halfedges[back]);
+				const std::size_t found = edgeIn(back);
+				if (found != Triangulation::InvalidIndex) {
+					return found;
+				}
+			}
+			break;
+		}
+		e = halfedges[incoming];
+	} while (e != start);
+	return Triangulation::InvalidIndex;
+}
+
+double
+ConstrainedDelaunay::orient(std::size_t a, std::size_t b, std::size_t c) const
+{
+	const std::vector<float>& coords = *myCoords;
+	return Predicates::orient2d(coords[2 * a], coords[2 * a + 1],
+								coords[2 * b], coords[2 * b + 1],
+								coords[2 * c], coords[2 * c + 1]);
+}
+
+std::size_t
+ConstrainedDelaunay::flip(std::size_t e)
+{
+	std::vector<std::size_t>& triangles = myTriangulation->triangles;
+	std::vector<std::size_t>& halfedges = myTriangulation->halfedges;
+
+	// e goes from p to q with r after them, its opposite f goes from q to p with s after them.
+	// Afterwards e goes from s to q and f from r to p, the new diagonal links r and s.
+	const std::size_t f = halfedges[e];
+	const std::size_t eNext = nextHalfedge(e);
+	const std::size_t ePrev = prevHalfedge(e);
+	const std::size_t fNext = nextHalfedge(f);
+	const std::size_t fPrev = prevHalfedge(f);
+
+	const std::size_t p = triangles[e];
+	const std::size_t q = triangles[eNext];
+	const std::size_t r = triangles[ePrev];
+	const std::size_t s = triangles[fPrev];
+
+	const std::size_t rpOpposite = halfedges[ePrev];
+	const std::size_t sqOpposite = halfedges[fPrev];
+	const uint8_t rpFlags = myFlags[ePrev];
+	const uint8_t sqFlags = myFlags[fPrev];
+
+	triangles[e] = s;
+	triangles[f] = r;
+
+	auto link = [&](std::size_t a, std::size_t b) {
+		halfedges[a] = b;
+		if (b != Triangulation::InvalidIndex) {
+			halfedges[b] = a;
+		}
+	};
+	link(e, sqOpposite);
+	link(f, rpOpposite);
+	link(ePrev, fPrev);
+
+	myFlags[e] = sqFlags;
+	myFlags[f] = rpFlags;
+	myFlags[ePrev] = 0;
+	myFlags[fPrev] = 0;
+
+	myVertexEdge[p] = fNext;
+	myVertexEdge[q] = eNext;
+	myVertexEdge[r] = ePrev;
+	myVertexEdge[s] = e;
+	return ePrev;
+}
+
+void
+ConstrainedDelaunay::markConstraint(std::size_t e)
+{
+	myFlags[e] = (myFlags[e] | ConstraintFlag) ^ ParityFlag;
+	const std::size_t opposite = myTriangulation->halfedges[e];
+	if (opposite != Triangulation::InvalidIndex) {
+		myFlags[opposite] = (myFlags[opposite] | ConstraintFlag) ^ ParityFlag;
+	}
+}
+
+bool
+ConstrainedDelaunay::insertSegment(std::size_t a, std::size_t b)
+{
+	const std::vector<float>& coords = *myCoords;
+	const std::vector<std::size_t>& triangles = myTriangulation->triangles;
+	const std::vector<std::size_t>& halfedges = myTriangulation->halfedges;
+
+	const std::size_t existing = findEdge(a, b);
+	if (existing != Triangulation::InvalidIndex) {
+		markConstraint(existing);
+		return true;
+	}
+
+	auto alongSegment = [&](std::size_t c) {
+		return orient(a, b, c) == 0.0 &&
+			(coords[2 * c] - coords[2 * a]) * (coords[2 * b] - coords[2 * a]) +
+			(coords[2 * c + 1] - coords[2 * a + 1]) * (coords[2 * b + 1] - coords[2 * a + 1]) > 0.0;
+	};
+
+	// the triangles are clockwise, so the segment leaves a through the triangle
+	// whose second point is on its left and third point on its right
+	gatherFan(a);
+	std::size_t crossed = Triangulation::InvalidIndex;
+	for (std::size_t e : myFan) {
+		const std::size_t c = triangles[nextHalfedge(e)];
+		const std::size_t d = triangles[prevHalfedge(e)];
+
+		// the segment goes along an edge, the rest of it starts from the point on it
+		const std::size_t along = alongSegment(c) ? e : alongSegment(d) ? prevHalfedge(e) : Triangulation::InvalidIndex;
+		if (along != Triangulation::InvalidIndex) {
+			markConstraint(along);
+			myPending.push_back(along == e ? c : d);
+			myPending.push_back(b);
+			return true;
+		}
+		if (orient(a, b, c) > 0.0 && orient(a, b, d) < 0.0) {
+			crossed = nextHalfedge(e);
+		}
+	}
+	if (crossed == Triangulation::InvalidIndex) {
+		return false;
+	}
+
+	// walk along the segment to gather the edges it crosses, with their start on its left
+	myCrossings.clear();
+	std::size_t h = crossed;
+	while (true) {
+		const std::size_t opposite = halfedges[h];
+		if ((myFlags[h] & ConstraintFlag) || opposite == Triangulation::InvalidIndex) {
+			return false;
+		}
+		myCrossings.push_back(triangles[h]);
+		myCrossings.push_back(triangles[opposite]);
+
+		const std::size_t v = triangles[prevHalfedge(opposite)];
+		if (v == b) {
+			break;
+		}
+		const double side = orient(a, b, v);
+		if (side == 0.0) {
+			// the segment goes through v, the rest of it starts from there
+			myPending.push_back(v);
+			myPending.push_back(b);
+			b = v;
+			break;
+		}
+		h = side > 0.0 ? prevHalfedge(opposite) : nextHalfedge(opposite);
+	}
+
+	auto crossesSegment = [&](std::size_t r, std::size_t s) {
+		if (r == a || r == b || s == a || s == b) {
+			return false;
+		}
+		const double sideR = orient(a, b, r);
+		const double sideS = orient(a, b, s);
+		const double sideA = orient(r, s, a);
+		const double sideB = orient(r, s, b);
+		return ((sideR > 0.0 && sideS < 0.0) || (sideR < 0.0 && sideS > 0.0)) &&
+			((sideA > 0.0 && sideB < 0.0) || (sideA < 0.0 && sideB > 0.0));
+	};
+
+	// flip the crossed edges whose quad is convex until none crosses the segment,
+	// the others are tried again later
+	myNewEdges.clear();
+	const std::size_t numCrossings = myCrossings.size() / 2;
+	std::size_t remainingTries = 64 + 16 * numCrossings * numCrossings;
+	for (std::size_t head = 0; head < myCrossings.size(); head += 2) {
+		if (remainingTries-- == 0) {
+			return false;
+		}
+
+		const std::size_t p = myCrossings[head];
+		const std::size_t q = myCrossings[head + 1];
+		const std::size_t e = findEdge(p, q);
+		if (e == Triangulation::InvalidIndex) {
+			return false;
+		}
+		const std::size_t r = triangles[prevHalfedge(e)];
+		const std::size_t s = triangles[prevHalfedge(halfedges[e])];
+
+		const double sideP = orient(r, s, p);
+		const double sideQ = orient(r, s, q);
+		if (!((sideP > 0.0 && sideQ < 0.0) || (sideP < 0.0 && sideQ > 0.0))) {
+			myCrossings.push_back(p);
+			myCrossings.push_back(q);
+			continue;
+		}
+
+		flip(e);
+		std::vector<std::size_t>& edges = crossesSegment(r, s) ? myCrossings : myNewEdges;
+		edges.push_back(r);
+		edges.push_back(s);
+	}
+
+	// then make the new edges delaunay again
+	bool flipped = true;
+	while (flipped) {
+		flipped = false;
+		for (std::size_t i = 0; i < myNewEdges.size(); i += 2) {
+			const std::size_t u = myNewEdges[i];
+			const std::size_t v = myNewEdges[i + 1];
+			if ((u == a && v == b) || (u == b && v == a)) {
+				continue;
+			}
+			const std::size_t e = findEdge(u, v);
+			if (e == Triangulation::InvalidIndex || (myFlags[e] & ConstraintFlag) || halfedges[e] == Triangulation::InvalidIndex) {
+				continue;
+			}
+
+			const std::size_t p = triangles[e];
+			const std::size_t q = triangles[nextHalfedge(e)];
+			const std::size_t r = triangles[prevHalfedge(e)];
+			const std::size_t s = triangles[prevHalfedge(halfedges[e])];
+			if (Predicates::inCircle(coords[2 * p], coords[2 * p + 1],
+									 coords[2 * q], coords[2 * q + 1],
+									 coords[2 * r], coords[2 * r + 1],
+									 coords[2 * s], coords[2 * s + 1]) < 0.0) {
+				flip(e);
+				myNewEdges[i] = r;
+				myNewEdges[i + 1] = s;
+				flipped = true;
+			}
+		}
+	}
+
+	const std::size_t e = findEdge(a, b);
+	if (e == Triangulation::InvalidIndex) {
+		return false;
+	}
+	markConstraint(e);
+	return true;
+}
+
+void
+ConstrainedDelaunay::removeOutside()
+{
+	std::vector<std::size_t>& triangles = myTriangulation->triangles;
+	std::vector<std::size_t>& halfedges = myTriangulation->halfedges;
+	const std::size_t numTriangles = triangles.size() / 3;
+
+	// flood the parity of the number of constraints crossed from the outside
+	myParity.assign(numTriangles, Unvisited);
+	myQueue.clear();
+	for (std::size_t e = 0; e < halfedges.size(); e++) {
+		if (halfedges[e] == Triangulation::InvalidIndex && myParity[e / 3] == Unvisited) {
+			myParity[e / 3] = (myFlags[e] & ParityFlag) ? 1 : 0;
+			myQueue.push_back(e / 3);
+		}
+	}
+	for (std::size_t head = 0; head < myQueue.size(); head++) {
+		const std::size_t t = myQueue[head];
+		for (std::size_t e = 3 * t; e < 3 * t + 3; e++) {
+			const std::size_t opposite = halfedges[e];
+			if (opposite == Triangulation::InvalidIndex || myParity[opposite / 3] != Unvisited) {
+				continue;
+			}
+			myParity[opposite / 3] = myParity[t] ^ ((myFlags[e] & ParityFlag) ? 1 : 0);
+			myQueue.push_back(opposite / 3);
+		}
+	}
+
+	// compact the inside triangles, their neighbours outside become the new hull
+	myQueue.assign(numTriangles, Triangulation::InvalidIndex);
+	std::size_t numKept = 0;
+	for (std::size_t t = 0; t < numTriangles; t++) {
+		if (myParity[t] == 1) {
+			myQueue[t] = numKept++;
+		}
+	}
+	for (std::size_t t = 0; t < numTriangles; t++) {
+		const std::size_t kept = myQueue[t];
+		if (kept == Triangulation::InvalidIndex) {
+			continue;
+		}
+		for (std::size_t k = 0; k < 3; k++) {
+			const std::size_t opposite = halfedges[3 * t + k];
+			const bool outside = opposite == Triangulation::InvalidIndex || myQueue[opposite / 3] == Triangulation::InvalidIndex;
+			triangles[3 * kept + k] = triangles[3 * t + k];
+			halfedges[3 * kept + k] = outside ? Triangulation::InvalidIndex : 3 * myQueue[opposite / 3] + opposite % 3;
+		}
+	}
+	triangles.resize(3 * numKept);
+	halfedges.resize(3 * numKept);
+}
+
+void
+ConstrainedDelaunay::constrain(const std::vector<float>& coords, const std::vector<int32_t>& edges, Triangulation& triangulation)
+{
+	myCoords = &coords;
+	myTriangulation = &triangulation;
+	myNumSkipped = 0;
+	myPlaces.clear();
+
+	const std::size_t numPoints = coords.size() / 2;
+	if (triangulation.triangles.empty() || edges.empty()) {
+		return;
+	}
+
+	myVertexEdge.assign(numPoints, Triangulation::InvalidIndex);
+	for (std::size_t e = 0; e < triangulation.triangles.size(); e++) {
+		myVertexEdge[triangulation.triangles[e]] = e;
+	}
+	myFlags.assign(triangulation.halfedges.size(), 0);
+
+	std::size_t numInserted = 0;
+	for (std::size_t i = 0; i + 1 < edges.size(); i += 2) {
+		if (edges[i] < 0 || edges[i + 1] < 0 ||
+			static_cast<std::size_t>(edges[i]) >= numPoints || static_cast<std::size_t>(edges[i + 1]) >= numPoints) {
+			myNumSkipped++;
+			continue;
+		}
+		const std::size_t a = findVertex(edges[i]);
+		const std::size_t b = findVertex(edges[i + 1]);
+		if (a == Triangulation::InvalidIndex || b == Triangulation::InvalidIndex) {
+			myNumSkipped++;
+			continue;
+		}
+
+		myPending.clear();
+		myPending.push_back(a);
+		myPending.push_back(b);
+		while (!myPending.empty()) {
+			const std::size_t end = myPending.back();
+			myPending.pop_back();
+			const std::size_t start = myPending.back();
+			myPending.pop_back();
+			if (start == end) {
+				continue;
+			}
+			if (!insertSegment(start, end)) {
+				myNumSkipped++;
+				break;
+			}
+			numInserted++;
+		}
+	}
+
+	if (numInserted > 0) {
+		removeOutside();
+	}
+}
+
+std::size_t
+ConstrainedDelaunay::getNumSkipped() const
+{
+	return myNumSkipped;
+}
+
+std::size_t
+ConstrainedDelaunay::getMemoryUsage() const
+{
+	// the nodes of the map are a guess, the standard doesn't tell their size
+	return (myVertexEdge.capacity() + myFan.capacity() + myPending.capacity() +
+			myCrossings.capacity() + myNewEdges.capacity() + myQueue.capacity()) * sizeof(std::size_t) +
+		(myFlags.capacity() + myParity.capacity()) * sizeof(uint8_t) +
+		myPlaces.size() * (sizeof(uint64_t) + sizeof(std::size_t) + 2 * sizeof(void*)) +
+		myPlaces.bucket_count() * sizeof(void*);
+}
+
+void
+ConstrainedDelaunay::releaseMemory()
+{
+	std::vector<std::size_t>().swap(myVertexEdge);
+	std::vector<uint8_t>().swap(myFlags);
+	std::unordered_map<uint64_t, std::size_t>().swap(myPlaces);
+	std::vector<std::size_t>().swap(myFan);
+	std::vector<std::size_t>().swap(myPending);
+	std::vector<std::size_t>().swap(myCrossings);
+	std::vector<std::size_t>().swap(myNewEdges);
+	std::vector<uint8_t>().swap(myParity);
+	std::vector<std::size_t>().swap(myQueue);
+}
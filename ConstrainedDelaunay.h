@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+// Turns a delaunay triangulation into a constrained delaunay triangulation.
+// Every constraint edge is forced into the triangulation by flipping the edges it
+// crosses (Sloan, "A fast algorithm for generating constrained Delaunay triangulations"),
+// then the new edges are flipped back to delaunay unless they are constraints themselves.
+// The triangles outside of the constraint loops are removed with the even-odd rule,
+// which leaves the holes of the outlines open.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class ConstrainedDelaunay
+{
+public:
+
+	ConstrainedDelaunay();
+
+	// edges holds two point indices per constraint. Constraints crossing a constraint
+	// inserted before them are left out.
+	void constrain(const std::vector<float>& coords, const std::vector<int32_t>& edges, Triangulation& triangulation);
+
+	// constraints left out by the last constrain
+	std::size_t getNumSkipped() const;
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// the point of the triangulation at the same place as point, which is point itself
+	// unless it is a duplicate left out by the triangulation
+	std::size_t findVertex(std::size_t point);
+
+	// fills myFan with the halfedges going out of point
+	void gatherFan(std::size_t point);
+
+	// the halfedge going from a to b, InvalidIndex when there is none
+	std::size_t findEdge(std::size_t a, std::size_t b);
+
+	double orient(std::size_t a, std::size_t b, std::size_t c) const;
+
+	// swaps the diagonal of the two triangles of e, returns the halfedge of the new diagonal
+	std::size_t flip(std::size_t e);
+
+	// flags both halfedges of e as a constraint
+	void markConstraint(std::size_t e);
+
+	// forces the segment from a to b into the triangulation, the part of the segment
+	// after a point lying on it is pushed to myPending. False when it crosses a constraint.
+	bool insertSegment(std::size_t a, std::size_t b);
+
+	// removes the triangles crossing an even number of constraints from the hull
+	void removeOutside();
+
+	// only valid during constrain
+	const std::vector<float>*	myCoords;
+	Triangulation*				myTriangulation;
+
+	std::size_t					myNumSkipped;
+
+	// a halfedge going out of every point, InvalidIndex for the points not triangulated
+	std::vector<std::size_t>	myVertexEdge;
+
+	// one byte per halfedge, see the flags in the .cpp
+	std::vector<uint8_t>		myFlags;
+
+	// the triangulated point at every place, only built when a constraint uses a duplicate point
+	std::unordered_map<uint64_t, std::size_t>	myPlaces;
+
+	std::vector<std::size_t>	myFan;
+	std::vector<std::size_t>	myPending;
+	std::vector<std::size_t>	myCrossings;
+	std::vector<std::size_t>	myNewEdges;
+
+	std::vector<uint8_t>		myParity;
+	std::vector<std::size_t>	myQueue;
+};
@@ -0,0 +1,192 @@
+#include "ConvexHull.h"
+#include "Predicates.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	// below this many points per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+
+	// the directions in which we look for the extreme points, counter clockwise
+	const int NumDirections = 8;
+	const double Directions[NumDirections][2] = {
+		{ -1.0, 0.0 }, { -1.0, -1.0 }, { 0.0, -1.0 }, { 1.0, -1.0 },
+		{ 1.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 1.0 }, { -1.0, 1.0 }
+	};
+}
+
+ConvexHull::ConvexHull() :
+	myCoords(nullptr)
+{
+}
+
+void
+ConvexHull::monotoneChain(const std::vector<uint32_t>& points, std::vector<uint32_t>& hull) const
+{
+	const std::vector<float>& coords = *myCoords;
+	auto turnsLeft = [&](uint32_t a, uint32_t b, uint32_t c) {
+		return Predicates::orient2d(coords[2 * a], coords[2 * a + 1],
+									coords[2 * b], coords[2 * b + 1],
+									coords[2 * c], coords[2 * c + 1]) > 0.0;
+	};
+
+	hull.clear();
+	if (points.size() < 3) {
+		hull.assign(points.begin(), points.end());
+	} else {
+		// lower hull from left to right, then upper hull from right to left
+		for (std::size_t i = 0; i < points.size(); i++) {
+			while (hull.size() >= 2 && !turnsLeft(hull[hull.size() - 2], hull.back(), points[i])) {
+				hull.pop_back();
+			}
+			hull.push_back(points[i]);
+		}
+		const std::size_t lowerSize = hull.size() + 1;
+		for (std::size_t i = points.size() - 1; i-- > 0;) {
+			while (hull.size() >= lowerSize && !turnsLeft(hull[hull.size() - 2], hull.back(), points[i])) {
+				hull.pop_back();
+			}
+			hull.push_back(points[i]);
+		}
+
+		// the first point closes the upper hull
+		hull.pop_back();
+	}
+
+	// all the points at the same place
+	if (hull.size() == 2 && coords[2 * hull[0]] == coords[2 * hull[1]] && coords[2 * hull[0] + 1] == coords[2 * hull[1] + 1]) {
+		hull.pop_back();
+	}
+}
+
+void
+ConvexHull::build(const std::vector<float>& coords, ThreadPool& pool)
+{
+	myCoords = &coords;
+	myIndices.clear();
+
+	const std::size_t numPoints = coords.size() / 2;
+	if (numPoints == 0) {
+		return;
+	}
+
+	const std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numPoints / MinChunkSize));
+	myChunkPoints.resize(numChunks);
+	myChunkHulls.resize(numChunks);
+
+	auto lessXY = [&](uint32_t a, uint32_t b) {
+		return coords[2 * a] < coords[2 * b] || (coords[2 * a] == coords[2 * b] && coords[2 * a + 1] < coords[2 * b + 1]);
+	};
+	auto extent = [&](uint32_t p, int direction) {
+		return Directions[direction][0] * coords[2 * p] + Directions[direction][1] * coords[2 * p + 1];
+	};
+
+	// the points going the furthest in each direction
+	std::vector<std::array<uint32_t, NumDirections>> chunkExtremes(numChunks);
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		const uint32_t begin = static_cast<uint32_t>(numPoints * chunk / numChunks);
+		const uint32_t end = static_cast<uint32_t>(numPoints * (chunk + 1) / numChunks);
+		std::array<uint32_t, NumDirections> extremes;
+		extremes.fill(begin);
+		for (uint32_t i = begin + 1; i < end; i++) {
+			for (int direction = 0; direction < NumDirections; direction++) {
+				if (extent(i, direction) > extent(extremes[direction], direction)) {
+					extremes[direction] = i;
+				}
+			}
+		}
+		chunkExtremes[chunk] = extremes;
+	});
+
+	std::array<uint32_t, NumDirections> extremes = chunkExtremes[0];
+	for (std::size_t chunk = 1; chunk < numChunks; chunk++) {
+		for (int direction = 0; direction < NumDirections; direction++) {
+			if (extent(chunkExtremes[chunk][direction], direction) > extent(extremes[direction], direction)) {
+				extremes[direction] = chunkExtremes[chunk][direction];
+			}
+		}
+	}
+
+	// the same point is often the extreme of neighbour directions
+	uint32_t corners[NumDirections];
+	int numCorners = 0;
+	for (int direction = 0; direction < NumDirections; direction++) {
+		const uint32_t p = extremes[direction];
+		if (numCorners == 0 || coords[2 * p] != coords[2 * corners[numCorners - 1]] ||
+			coords[2 * p + 1] != coords[2 * corners[numCorners - 1] + 1]) {
+			corners[numCorners++] = p;
+		}
+	}
+	while (numCorners > 1 && coords[2 * corners[0]] == coords[2 * corners[numCorners - 1]] &&
+		   coords[2 * corners[0] + 1] == coords[2 * corners[numCorners - 1] + 1]) {
+		numCorners--;
+	}
+
+	// a point on the left of every side of the octagon is inside the hull of its corners,
+	// so it can't be on the hull
+	auto insideOctagon = [&](uint32_t p) {
+		if (numCorners < 3) {
+			return false;
+		}
+		for (int side = 0; side < numCorners; side++) {
+			const uint32_t a = corners[side];
+			const uint32_t b = corners[(side + 1) % numCorners];
+			if (!(Predicates::orient2d(coords[2 * a], coords[2 * a + 1],
+									   coords[2 * b], coords[2 * b + 1],
+									   coords[2 * p], coords[2 * p + 1]) > 0.0)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::vector<uint32_t>& points = myChunkPoints[chunk];
+		points.clear();
+		for (std::size_t i = numPoints * chunk / numChunks; i < numPoints * (chunk + 1) / numChunks; i++) {
+			if (!insideOctagon(static_cast<uint32_t>(i))) {
+				points.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		std::sort(points.begin(), points.end(), lessXY);
+		monotoneChain(points, myChunkHulls[chunk]);
+	});
+
+	myCandidates.clear();
+	for (const std::vector<uint32_t>& hull : myChunkHulls) {
+		myCandidates.insert(myCandidates.end(), hull.begin(), hull.end());
+	}
+	std::sort(myCandidates.begin(), myCandidates.end(), lessXY);
+	monotoneChain(myCandidates, myIndices);
+}
+
+const std::vector<uint32_t>&
+ConvexHull::getIndices() const
+{
+	return myIndices;
+}
+
+std::size_t
+ConvexHull::getMemoryUsage() const
+{
+	std::size_t size = (myCandidates.capacity() + myIndices.capacity()) * sizeof(uint32_t);
+	for (const std::vector<uint32_t>& points : myChunkPoints) {
+		size += points.capacity() * sizeof(uint32_t);
+	}
+	for (const std::vector<uint32_t>& hull : myChunkHulls) {
+		size += hull.capacity() * sizeof(uint32_t);
+	}
+	return size;
+}
+
+void
+ConvexHull::releaseMemory()
+{
+	std::vector<std::vector<uint32_t>>().swap(myChunkPoints);
+	std::vector<std::vector<uint32_t>>().swap(myChunkHulls);
+	std::vector<uint32_t>().swap(myCandidates);
+	std::vector<uint32_t>().swap(myIndices);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+
+// Convex hull of 2d points, without triangulating them.
+// The points inside the octagon of the extreme points are thrown away first
+// (Akl-Toussaint), then every chunk of points gets its own hull with Andrew's
+// monotone chain in parallel, and a last monotone chain merges the chunk hulls.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class ConvexHull
+{
+public:
+
+	ConvexHull();
+
+	// coords holds x0, y0, x1, y1, ...
+	void build(const std::vector<float>& coords, ThreadPool& pool);
+
+	// indices of the points on the hull, counter clockwise, without aligned points
+	const std::vector<uint32_t>& getIndices() const;
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// writes the hull of the points, which must be sorted by x then y
+	void monotoneChain(const std::vector<uint32_t>& points, std::vector<uint32_t>& hull) const;
+
+	// only valid during build
+	const std::vector<float>*			myCoords;
+
+	std::vector<std::vector<uint32_t>>	myChunkPoints;
+	std::vector<std::vector<uint32_t>>	myChunkHulls;
+	std::vector<uint32_t>				myCandidates;
+	std::vector<uint32_t>				myIndices;
+};
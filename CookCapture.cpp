@@ -0,0 +1,184 @@
+#include "CookCapture.h"
+#include "Hash.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+	// the hash of an unconnected input
+	const uint64_t NoInput = 0;
+}
+
+CookCapture::CookCapture() :
+	myFile(nullptr),
+	myCooksLeft(0),
+	myFailed(false)
+{
+}
+
+CookCapture::~CookCapture()
+{
+	stop();
+}
+
+bool
+CookCapture::start(const char* path, int32_t numCooks, std::string& error)
+{
+	stop();
+	if (!path || !*path) {
+		error = "No capture file";
+		return false;
+	}
+
+	myFile = fopen(path, "wb");
+	if (!myFile) {
+		error = std::string("Can't write the capture file ") + path + ": " + strerror(errno);
+		return false;
+	}
+	myCooksLeft = numCooks > 0 ? numCooks : 1;
+	myFailed = false;
+	myInputHashes.clear();
+
+	writeValue(Magic);
+	writeValue(Version);
+	return true;
+}
+
+bool
+CookCapture::isCapturing() const
+{
+	return myFile != nullptr;
+}
+
+bool
+CookCapture::record(const OP_Inputs* inputs, const Parameter* parameters, std::size_t numParameters)
+{
+	if (!myFile) {
+		return true;
+	}
+
+	const OP_TimeInfo* time = inputs->getTimeInfo();
+	writeValue(time->absFrame);
+	writeValue(time->frame);
+	writeValue(time->rate);
+	writeValue(time->rootFrame);
+	writeValue(time->rootRate);
+	writeValue(time->deltaFrames);
+	writeValue(time->deltaMS);
+
+	writeValue(static_cast<uint32_t>(numParameters));
+	for (std::size_t i = 0; i < numParameters; i++) {
+		const Parameter& parameter = parameters[i];
+		writeText(parameter.name);
+		writeValue(parameter.type);
+		if (parameter.type == ParameterType::numeric) {
+			writeValue(static_cast<uint32_t>(parameter.numValues));
+			for (int32_t j = 0; j < parameter.numValues; j++) {
+				writeValue(inputs->getParDouble(parameter.name, j));
+			}
+		} else {
+			writeText(inputs->getParString(parameter.name));
+		}
+	}
+
+	const int32_t numInputs = inputs->getNumInputs();
+	myInputHashes.resize(std::max<std::size_t>(myInputHashes.size(), numInputs), NoInput);
+	writeValue(static_cast<uint32_t>(numInputs));
+	for (int32_t i = 0; i < numInputs; i++) {
+		writeInput(inputs->getInputSOP(i), i);
+	}
+
+	if (--myCooksLeft <= 0 || myFailed) {
+		return stop();
+	}
+	return true;
+}
+
+void
+CookCapture::writeInput(const OP_SOPInput* input, std::size_t index)
+{
+	const int32_t numPoints = input ? input->getNumPoints() : 0;
+	const int32_t numPrimitives = input ? input->getNumPrimitives() : 0;
+	const Position* positions = input ? input->getPointPositions() : nullptr;
+
+	// the points of the primitives back to back, to hash and write them at once
+	myPrimitivePoints.clear();
+	for (int32_t i = 0; i < numPrimitives; i++) {
+		const SOP_PrimitiveInfo primitive = input->getPrimitive(i);
+		myPrimitivePoints.insert(myPrimitivePoints.end(), primitive.pointIndices, primitive.pointIndices + primitive.numVertices);
+	}
+
+	uint64_t hash = NoInput;
+	if (input) {
+		hash = hashBytes(positions, numPoints * sizeof(Position), numPrimitives);
+		hash = hashBytes(myPrimitivePoints.data(), myPrimitivePoints.size() * sizeof(int32_t), hash);
+		for (int32_t i = 0; i < input->getNumCustomAttributes(); i++) {
+			const SOP_CustomAttribData* attribute = input->getCustomAttribute(i);
+			const std::size_t size = static_cast<std::size_t>(numPoints) * attribute->numComponents * 4;
+			hash = hashBytes(attribute->name, strlen(attribute->name), hash);
+			hash = hashBytes(attribute->attribType == AttribType::Int ? static_cast<const void*>(attribute->intData) : attribute->floatData, size, hash);
+		}
+		// an input is never mistaken for no input
+		hash |= 1;
+	}
+
+	const bool changed = hash != myInputHashes[index];
+	myInputHashes[index] = hash;
+	writeValue(static_cast<uint8_t>(changed));
+	if (!changed) {
+		return;
+	}
+
+	writeValue(static_cast<uint32_t>(numPoints));
+	write(positions, numPoints * sizeof(Position));
+
+	writeValue(static_cast<uint32_t>(numPrimitives));
+	for (int32_t i = 0; i < numPrimitives; i++) {
+		writeValue(input->getPrimitive(i).numVertices);
+	}
+	write(myPrimitivePoints.data(), myPrimitivePoints.size() * sizeof(int32_t));
+
+	const int32_t numAttributes = input ? input->getNumCustomAttributes() : 0;
+	writeValue(static_cast<uint32_t>(numAttributes));
+	for (int32_t i = 0; i < numAttributes; i++) {
+		const SOP_CustomAttribData* attribute = input->getCustomAttribute(i);
+		const bool isInt = attribute->attribType == AttribType::Int;
+		writeText(attribute->name);
+		writeValue(static_cast<uint8_t>(attribute->attribType));
+		writeValue(attribute->numComponents);
+		write(isInt ? static_cast<const void*>(attribute->intData) : attribute->floatData,
+			  static_cast<std::size_t>(numPoints) * attribute->numComponents * 4);
+	}
+}
+
+bool
+CookCapture::stop()
+{
+	if (!myFile) {
+		return true;
+	}
+	bool ok = fclose(myFile) == 0 && !myFailed;
+	myFile = nullptr;
+	myCooksLeft = 0;
+	std::vector<uint64_t>().swap(myInputHashes);
+	std::vector<int32_t>().swap(myPrimitivePoints);
+	return ok;
+}
+
+void
+CookCapture::write(const void* data, std::size_t size)
+{
+	if (size > 0 && !myFailed && fwrite(data, 1, size, myFile) != size) {
+		myFailed = true;
+	}
+}
+
+void
+CookCapture::writeText(const char* text)
+{
+	const uint32_t length = text ? static_cast<uint32_t>(strlen(text)) : 0;
+	writeValue(length);
+	write(text, length);
+}
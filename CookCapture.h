@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CPlusPlus_Common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+// Records what the node is cooked with for a number of cooks, to cook it again the same
+// way outside of TouchDesigner (harness/sopreplay).
+// The file starts with Magic and Version as uint32, then every cook is:
+//	the time:		int64 absFrame, double frame, rate, rootFrame, rootRate, deltaFrames, deltaMS
+//	parameters:		uint32 count, then per parameter its name, uint8 ParameterType, and either
+//					uint32 count then the doubles of a numeric parameter, or the text of the others
+//	inputs:			uint32 count, then per input an uint8 set when it changed since the last cook
+//					of the file, only then followed by uint32 numPoints, the positions as 3 floats,
+//					uint32 numPrimitives, the int32 number of vertices of every primitive, their
+//					int32 point indices, uint32 numAttributes, and per attribute its name,
+//					uint8 AttribType, int32 numComponents and the values of every point
+// Texts are an uint32 length followed by the characters, numbers are in the byte order of the machine.
+class CookCapture
+{
+public:
+
+	static const uint32_t Magic = 0x43535444;
+	static const uint32_t Version = 1;
+
+	enum class ParameterType : uint8_t { numeric, text };
+
+	// the parameters to record, menus are text
+	struct Parameter
+	{
+		const char*			name;
+		ParameterType		type;
+		int32_t				numValues;
+	};
+
+	CookCapture();
+
+	~CookCapture();
+
+	CookCapture(const CookCapture&) = delete;
+	CookCapture& operator=(const CookCapture&) = delete;
+
+	// creates the file, the next numCooks cooks go in it. error tells why it failed.
+	bool start(const char* path, int32_t numCooks, std::string& error);
+
+	bool isCapturing() const;
+
+	// writes one cook, and closes the file after the last one.
+	// False when the file couldn't be written, the capture is then stopped.
+	bool record(const OP_Inputs* inputs, const Parameter* parameters, std::size_t numParameters);
+
+	// closes the file, false when a write failed since start
+	bool stop();
+
+private:
+
+	void write(const void* data, std::size_t size);
+	void writeText(const char* text);
+
+	template <typename T>
+	void
+	writeValue(T value)
+	{
+		write(&value, sizeof(T));
+	}
+
+	void writeInput(const OP_SOPInput* input, std::size_t index);
+
+	FILE*						myFile;
+	int32_t						myCooksLeft;
+	bool						myFailed;
+
+	// hash of every input at the last recorded cook, an unchanged input is written once
+	std::vector<uint64_t>		myInputHashes;
+	std::vector<int32_t>		myPrimitivePoints;
+};
@@ -0,0 +1,54 @@
+#include "CookHistory.h"
+
+#include <algorithm>
+
+CookHistory::CookHistory() :
+	mySlots(),
+	myNumRecorded(0)
+{
+}
+
+void
+CookHistory::record(const Record& record)
+{
+	const uint64_t numRecorded = myNumRecorded.load(std::memory_order_relaxed);
+	Slot& slot = mySlots[numRecorded % Capacity];
+
+	// odd while the record is being written
+	const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.record = record;
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+
+	myNumRecorded.store(numRecorded + 1, std::memory_order_release);
+}
+
+int32_t
+CookHistory::getNumRecords() const
+{
+	return static_cast<int32_t>(std::min<uint64_t>(myNumRecorded.load(std::memory_order_acquire), Capacity));
+}
+
+bool
+CookHistory::read(int32_t row, Record& record) const
+{
+	const uint64_t numRecorded = myNumRecorded.load(std::memory_order_acquire);
+	if (row < 0 || static_cast<uint64_t>(row) >= std::min<uint64_t>(numRecorded, Capacity)) {
+		return false;
+	}
+
+	// a slot written again meanwhile holds a newer cook, which is as good
+	const Slot& slot = mySlots[(numRecorded - 1 - row) % Capacity];
+	while (true) {
+		const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+		record = slot.record;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == before) {
+			return true;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CookTimings.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+// The last cooks of the node, for the Info DAT.
+// The records live in a ring allocated with the object, so recording a cook neither
+// allocates nor locks: every slot has a sequence number, odd while it is written, and
+// a reader copies a record and tries again if the sequence changed meanwhile.
+// Only one thread records, any thread can read.
+class CookHistory
+{
+public:
+
+	static const int32_t Capacity = 128;
+
+	enum class Cache : uint8_t
+	{
+		// the input changed
+		miss,
+
+		// the input didn't change, the last result was reused
+		hit,
+
+		// the cook waited for the background, or had no input
+		none,
+	};
+
+	struct Record
+	{
+		int64_t			frame;
+		uint32_t		inputPoints;
+		uint32_t		outputTriangles;
+		uint32_t		hullSize;
+		uint32_t		duplicates;
+		Cache			cache;
+		float			stageMs[CookTimings::NumStages];
+
+		// bytes held by the node at the end of the cook, before giving any back
+		uint64_t		peakMemory;
+	};
+
+	CookHistory();
+
+	CookHistory(const CookHistory&) = delete;
+	CookHistory& operator=(const CookHistory&) = delete;
+
+	void record(const Record& record);
+
+	// up to Capacity
+	int32_t getNumRecords() const;
+
+	// row 0 is the last cook, false when there are not that many
+	bool read(int32_t row, Record& record) const;
+
+private:
+
+	struct Slot
+	{
+		std::atomic<uint32_t>	sequence;
+		Record					record;
+	};
+
+	Slot					mySlots[Capacity];
+	std::atomic<uint64_t>	myNumRecorded;
+};
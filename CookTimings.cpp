@@ -0,0 +1,94 @@
+#include "CookTimings.h"
+
+#include <algorithm>
+
+namespace
+{
+	const char* const StageNames[] = { "projection", "triangulation", "conversion", "output", "cook" };
+}
+
+CookTimings::Scope::Scope(CookTimings& timings, Stage stage) :
+	myTimings(timings),
+	myPrevious(timings.myStage),
+	mySpan(getName(stage))
+{
+	myTimings.switchTo(static_cast<int>(stage));
+}
+
+CookTimings::Scope::~Scope()
+{
+	myTimings.switchTo(myPrevious);
+}
+
+CookTimings::CookTimings() :
+	myStage(-1),
+	myCurrent(),
+	myHistory(),
+	myNumCooks(0),
+	myNext(0),
+	mySummaries()
+{
+}
+
+void
+CookTimings::switchTo(int stage)
+{
+	const Clock::time_point now = Clock::now();
+	if (myStage >= 0) {
+		myCurrent[myStage] += std::chrono::duration<double, std::milli>(now - myLastSwitch).count();
+	}
+	myLastSwitch = now;
+	myStage = stage;
+}
+
+void
+CookTimings::beginCook()
+{
+	std::fill(myCurrent, myCurrent + NumStages, 0.0);
+	myStage = -1;
+	myCookStart = Clock::now();
+}
+
+void
+CookTimings::endCook()
+{
+	const Clock::time_point now = Clock::now();
+	myCurrent[static_cast<int>(Stage::cook)] = std::chrono::duration<double, std::milli>(now - myCookStart).count();
+	if (CookTrace* trace = CookTrace::getCurrent()) {
+		trace->addSpan(getName(Stage::cook), myCookStart, now);
+	}
+
+	myNumCooks = std::min(myNumCooks + 1, WindowSize);
+	for (int stage = 0; stage < NumStages; stage++) {
+		myHistory[stage][myNext] = myCurrent[stage];
+
+		// a copy to find the 95th percentile without reordering the history
+		double sorted[WindowSize];
+		std::copy(myHistory[stage], myHistory[stage] + myNumCooks, sorted);
+		double sum = 0.0;
+		for (int i = 0; i < myNumCooks; i++) {
+			sum += sorted[i];
+		}
+		double* p95 = sorted + (myNumCooks * 95 - 1) / 100;
+		std::nth_element(sorted, p95, sorted + myNumCooks);
+
+		Summary& summary = mySummaries[stage];
+		summary.last = myCurrent[stage];
+		summary.mean = sum / myNumCooks;
+		summary.p95 = *p95;
+		summary.max = *std::max_element(p95, sorted + myNumCooks);
+	}
+	myNext = (myNext + 1) % WindowSize;
+}
+
+const CookTimings::Summary&
+CookTimings::getSummary(Stage stage) const
+{
+	return mySummaries[static_cast<int>(stage)];
+}
+
+const char*
+CookTimings::getName(Stage stage)
+{
+	return StageNames[static_cast<int>(stage)];
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CookTrace.h"
+
+#include <chrono>
+#include <cstdint>
+
+
+// Time spent by the cooks in every stage, and its statistics over the last cooks.
+// A Scope charges the time to its stage until it ends or a nested Scope starts, so
+// the stages never count the same time twice and a stage can wrap a whole function
+// with the writes inside of it charged to output.
+// Nothing is allocated, a cook only reads the clock when it changes stage.
+// While the cook is traced, every Scope and the cook are also spans of the trace.
+class CookTimings
+{
+public:
+
+	enum class Stage
+	{
+		// hashing, projecting and gathering the input
+		projection,
+
+		// the triangulation, or the part of a job done by the cook
+		triangulation,
+
+		// culling and building what is output from the triangulation
+		conversion,
+
+		// the calls to SOP_Output and the writes to the vbo
+		output,
+
+		// the whole cook, charged by beginCook and endCook
+		cook,
+	};
+
+	static constexpr int NumStages = 5;
+
+	// the statistics are over this many cooks
+	static constexpr int WindowSize = 120;
+
+	// in milliseconds
+	struct Summary
+	{
+		double		last;
+		double		mean;
+		double		p95;
+		double		max;
+	};
+
+	class Scope
+	{
+	public:
+
+		Scope(CookTimings& timings, Stage stage);
+
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+
+		CookTimings&		myTimings;
+		int					myPrevious;
+		CookTrace::Scope	mySpan;
+	};
+
+	CookTimings();
+
+	void beginCook();
+
+	// adds the cook to the window and updates the summaries
+	void endCook();
+
+	const Summary& getSummary(Stage stage) const;
+
+	// lowercase, to name the channels
+	static const char* getName(Stage stage);
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	// charges the time since the last switch to the current stage
+	void switchTo(int stage);
+
+	Clock::time_point	myCookStart;
+	Clock::time_point	myLastSwitch;
+
+	// the stage being timed, -1 outside of the stages
+	int					myStage;
+
+	double				myCurrent[NumStages];
+	double				myHistory[NumStages][WindowSize];
+	int					myNumCooks;
+	int					myNext;
+	Summary				mySummaries[NumStages];
+};
@@ -0,0 +1,220 @@
+#include "CookTrace.h"
+
+#include <errno.h>
+#include <string.h>
+
+namespace
+{
+	// the writer wakes up this often, or sooner when this many spans are waiting
+	const auto FlushInterval = std::chrono::milliseconds(100);
+	const std::size_t FlushSize = 1 << 14;
+
+	// spans past this many are dropped while the writer is behind
+	const std::size_t MaxPendingSpans = 1 << 20;
+
+	struct ThreadState
+	{
+		CookTrace*		current = nullptr;
+		const char*		name = "cook";
+		uint32_t		id = 0;
+	};
+
+	thread_local ThreadState theThread;
+
+	std::atomic<uint32_t> theNextThreadId{ 1 };
+
+	uint32_t
+	getThreadId()
+	{
+		if (theThread.id == 0) {
+			theThread.id = theNextThreadId++;
+		}
+		return theThread.id;
+	}
+}
+
+CookTrace::Scope::Scope(const char* name) :
+	myTrace(theThread.current),
+	myName(name)
+{
+	if (myTrace) {
+		myBegin = Clock::now();
+	}
+}
+
+CookTrace::Scope::~Scope()
+{
+	if (myTrace) {
+		myTrace->addSpan(myName, myBegin, Clock::now());
+	}
+}
+
+CookTrace::CookTrace() :
+	myFile(nullptr),
+	myStop(false),
+	myTracing(false),
+	myFailed(false),
+	myFirstEvent(true)
+{
+}
+
+CookTrace::~CookTrace()
+{
+	stop();
+}
+
+bool
+CookTrace::start(const char* path, std::string& error)
+{
+	stop();
+	if (!path || !*path) {
+		error = "No trace file";
+		return false;
+	}
+
+	myFile = fopen(path, "w");
+	if (!myFile) {
+		error = std::string("Can't write the trace file ") + path + ": " + strerror(errno);
+		return false;
+	}
+	fputs("[", myFile);
+	myFirstEvent = true;
+	myNamedThreads.clear();
+	myFailed = false;
+	myStart = Clock::now();
+	myPending.reserve(FlushSize);
+	myWriting.reserve(FlushSize);
+
+	myStop = false;
+	myWriter = std::thread(&CookTrace::writerLoop, this);
+	myTracing = true;
+	return true;
+}
+
+bool
+CookTrace::isTracing() const
+{
+	return myTracing;
+}
+
+bool
+CookTrace::stop()
+{
+	if (!myFile) {
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(myMutex);
+		myTracing = false;
+		myStop = true;
+	}
+	myCondition.notify_all();
+	myWriter.join();
+
+	// an unclosed array is still read, this only makes the file strict json
+	fputs("\n]\n", myFile);
+	if (fclose(myFile) != 0) {
+		myFailed = true;
+	}
+	myFile = nullptr;
+	return !myFailed;
+}
+
+bool
+CookTrace::hasFailed() const
+{
+	return myFailed;
+}
+
+void
+CookTrace::addSpan(const char* name, Clock::time_point begin, Clock::time_point end)
+{
+	Span span;
+	span.name = name;
+	span.threadName = theThread.name;
+	span.thread = getThreadId();
+
+	bool flush = false;
+	{
+		std::lock_guard<std::mutex> lock(myMutex);
+		if (!myTracing || myPending.size() >= MaxPendingSpans) {
+			return;
+		}
+		span.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - myStart).count();
+		span.end = std::chrono::duration_cast<std::chrono::nanoseconds>(end - myStart).count();
+		myPending.push_back(span);
+		flush = myPending.size() == FlushSize;
+	}
+	if (flush) {
+		myCondition.notify_all();
+	}
+}
+
+CookTrace*
+CookTrace::getCurrent()
+{
+	return theThread.current;
+}
+
+void
+CookTrace::setCurrent(CookTrace* trace)
+{
+	theThread.current = trace;
+}
+
+void
+CookTrace::setThreadName(const char* name)
+{
+	theThread.name = name;
+}
+
+void
+CookTrace::writerLoop()
+{
+	while (true) {
+		bool stopping;
+		{
+			std::unique_lock<std::mutex> lock(myMutex);
+			myCondition.wait_for(lock, FlushInterval, [this] { return myStop || myPending.size() >= FlushSize; });
+			myPending.swap(myWriting);
+			stopping = myStop;
+		}
+
+		write(myWriting);
+		myWriting.clear();
+		if (stopping) {
+			return;
+		}
+	}
+}
+
+void
+CookTrace::write(const std::vector<Span>& spans)
+{
+	if (spans.empty() || myFailed) {
+		return;
+	}
+
+	for (const Span& span : spans) {
+		// the first span of a thread names its track
+		if (myNamedThreads.size() <= span.thread) {
+			myNamedThreads.resize(span.thread + 1, 0);
+		}
+		if (!myNamedThreads[span.thread]) {
+			myNamedThreads[span.thread] = 1;
+			fprintf(myFile, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+					myFirstEvent ? "" : ",", span.thread, span.threadName);
+			myFirstEvent = false;
+		}
+
+		// in microseconds
+		fprintf(myFile, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				myFirstEvent ? "" : ",", span.name, span.thread, span.begin / 1000.0, (span.end - span.begin) / 1000.0);
+		myFirstEvent = false;
+	}
+
+	if (fflush(myFile) != 0 || ferror(myFile)) {
+		myFailed = true;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Writes the spans of the cooks to a trace event file, opened by chrome://tracing or
+// ui.perfetto.dev, every thread on its own track.
+// A span is a name, a thread and two clock readings added to a buffer under a short
+// lock, a thread of the trace takes the buffer a few times per second and does the
+// formatting and the writes, so the cooks never wait for the disk.
+// The spans are recorded to the trace current on the calling thread, which the node sets
+// for its cook and the pool passes on to the threads helping with a parallelFor.
+class CookTrace
+{
+public:
+
+	using Clock = std::chrono::steady_clock;
+
+	// records a span from its creation to its end in the current trace, if any.
+	// name must outlive the trace, like a string literal.
+	class Scope
+	{
+	public:
+
+		explicit Scope(const char* name);
+
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+
+		CookTrace*			myTrace;
+		const char*			myName;
+		Clock::time_point	myBegin;
+	};
+
+	CookTrace();
+
+	// stops the trace
+	~CookTrace();
+
+	CookTrace(const CookTrace&) = delete;
+	CookTrace& operator=(const CookTrace&) = delete;
+
+	// creates the file and the thread writing it. error tells why it failed.
+	bool start(const char* path, std::string& error);
+
+	bool isTracing() const;
+
+	// writes what is left and closes the file, false when a write failed since start
+	bool stop();
+
+	// a write failed, the spans are then dropped
+	bool hasFailed() const;
+
+	// name must outlive the trace, from any thread
+	void addSpan(const char* name, Clock::time_point begin, Clock::time_point end);
+
+	// the trace the spans of the calling thread go to, null for none
+	static CookTrace* getCurrent();
+	static void setCurrent(CookTrace* trace);
+
+	// names the track of the calling thread, the threads cooking are "cook"
+	static void setThreadName(const char* name);
+
+private:
+
+	struct Span
+	{
+		const char*		name;
+		const char*		threadName;
+		uint32_t		thread;
+		int64_t			begin;
+		int64_t			end;
+	};
+
+	void writerLoop();
+
+	void write(const std::vector<Span>& spans);
+
+	FILE*						myFile;
+	Clock::time_point			myStart;
+	std::thread					myWriter;
+
+	// the spans not taken by the writer yet, swapped with myWriting so both keep their capacity
+	std::mutex					myMutex;
+	std::condition_variable		myCondition;
+	std::vector<Span>			myPending;
+	std::vector<Span>			myWriting;
+	bool						myStop;
+
+	std::atomic<bool>			myTracing;
+	std::atomic<bool>			myFailed;
+
+	// written by the writer only
+	std::vector<uint8_t>		myNamedThreads;
+	bool						myFirstEvent;
+};
@@ -18,7 +18,45 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
-#include "delaunator-cpp/include/delaunator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "Hash.h"
+
+namespace
+{
+	// below this many points per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+
+	// the info chop channels before those of the timings
+	const int32_t NumCountChannels = 8;
+
+	// the sizes, the cache, the time of every stage and the memory of a cook
+	const int32_t NumHistoryColumns = 6 + CookTimings::NumStages + 1;
+
+	// what a capture records of the parameters, all but those of the capture and the trace
+	const CookCapture::Parameter CapturedParameters[] = {
+		{ "Planeorientation", CookCapture::ParameterType::text, 0 },
+		{ "Planeorigin", CookCapture::ParameterType::numeric, 3 },
+		{ "Planenormal", CookCapture::ParameterType::numeric, 3 },
+		{ "Limitmode", CookCapture::ParameterType::text, 0 },
+		{ "Engine", CookCapture::ParameterType::text, 0 },
+		{ "Triangulateper", CookCapture::ParameterType::text, 0 },
+		{ "Partitionattribute", CookCapture::ParameterType::text, 0 },
+		{ "Constrained", CookCapture::ParameterType::numeric, 1 },
+		{ "Outputmode", CookCapture::ParameterType::text, 0 },
+		{ "Voronoipadding", CookCapture::ParameterType::numeric, 1 },
+		{ "Cullmode", CookCapture::ParameterType::text, 0 },
+		{ "Cullthreshold", CookCapture::ParameterType::numeric, 1 },
+		{ "Maskmode", CookCapture::ParameterType::text, 0 },
+		{ "Maxretainedmemory", CookCapture::ParameterType::numeric, 1 },
+		{ "Background", CookCapture::ParameterType::numeric, 1 },
+		{ "Cookbudget", CookCapture::ParameterType::numeric, 1 },
+		{ "Maxthreads", CookCapture::ParameterType::numeric, 1 },
+		{ "Sharedpoints", CookCapture::ParameterType::numeric, 1 },
+		{ "Directtogpu", CookCapture::ParameterType::numeric, 1 },
+	};
+}
 
 // These functions are basic C function, which the DLL loader can find
 // much easier than finding a C++ Class.
@@ -49,9 +87,9 @@ extern "C"
 		info->customOPInfo.authorName->setString("Colas Fiszman");
 		info->customOPInfo.authorEmail->setString("colas.fiszman@gmail.com");
 
-		// This SOP works with 0 or 1 inputs
+		// This SOP works with 1 or 2 inputs, the polygons of the second one mask the triangles
 		info->customOPInfo.minInputs = 1;
-		info->customOPInfo.maxInputs = 1;
+		info->customOPInfo.maxInputs = 2;
 
 	}
 
@@ -77,7 +115,33 @@ extern "C"
 };
 
 
-DelaunayTriangulationSop::DelaunayTriangulationSop(const OP_NodeInfo* info) : myNodeInfo(info)
+DelaunayTriangulationSop::DelaunayTriangulationSop(const OP_NodeInfo* info) : myNodeInfo(info),
+	myFrame(0),
+	myNumInputPoints(0),
+	myNumOutputPoints(0),
+	myNumOutputTriangles(0),
+	myCookCacheHits(0),
+	myCookCacheMisses(0),
+	myCookMemory(0),
+	myHasCoords(false),
+	myTriangulationEngine(Engine::sweepHull),
+	myHasTriangulation(false),
+	myConstraintHash(0),
+	myNumPartitions(0),
+	myPartitionHash(0),
+	myInputHash(0),
+	myInputStats(),
+	myPlane(),
+	myCacheHits(0),
+	myCacheMisses(0),
+	myResultFrame(-1),
+	myResultHash(0),
+	myResultSkipped(0),
+	myBackgroundInput(),
+	myBackgroundPending(false),
+	myCaptureRequested(false),
+	myMaskHash(0),
+	myHasMask(false)
 {
 }
 
@@ -89,170 +153,918 @@ DelaunayTriangulationSop::~DelaunayTriangulationSop()
 void
 DelaunayTriangulationSop::getGeneralInfo(SOP_GeneralInfo* ginfo, const OP_Inputs* inputs, void* reserved)
 {
-	// This will cause the node to cook every frame
-	ginfo->cookEveryFrameIfAsked = false;
+	// cook every frame while the background triangulation is behind the input
+	bool deferred = inputs->getParInt("Background") != 0 || inputs->getParDouble("Cookbudget") > 0.0;
+	ginfo->cookEveryFrameIfAsked = deferred && myBackgroundPending;
+
+	//if direct to GPU loading, which only draws triangles:
+	OutputMode outputMode = getOutputMode(inputs);
+	ginfo->directToGPU = inputs->getParInt("Directtogpu") != 0 && outputMode == OutputMode::triangles;
+	inputs->enablePar("Voronoipadding", outputMode == OutputMode::voronoi);
+	// the boundary loops are the outlines of the culled triangles
+	bool culled = outputMode == OutputMode::triangles || outputMode == OutputMode::boundary;
+	inputs->enablePar("Cullmode", culled);
+	inputs->enablePar("Cullthreshold", culled && getCullMode(inputs) != TriangleCulling::none);
+	inputs->enablePar("Maskmode", culled && inputs->getNumInputs() > 1);
+
+	inputs->enablePar("Partitionattribute", getPartitionMode(inputs) == PartitionMode::attribute);
+
+	// the plane parameters only apply to a custom plane
+	bool customPlane = getLimitedAxis(inputs) == Axis::custom;
+	inputs->enablePar("Planeorigin", customPlane);
+	inputs->enablePar("Planenormal", customPlane);
 
-	//if direct to GPU loading:
-	ginfo->directToGPU = false;
+}
 
+DelaunayTriangulationSop::Axis
+DelaunayTriangulationSop::getLimitedAxis(const OP_Inputs* inputs) {
+	// get the orientation of the plane on which we will project the points on
+	const char* planeOrientation = inputs->getParString("Planeorientation");
+
+	Axis limitedAxis = Axis::z;
+	if (strcmp(planeOrientation, "XY") == 0) limitedAxis = Axis::z;
+	else if (strcmp(planeOrientation, "YZ") == 0) limitedAxis = Axis::x;
+	else if (strcmp(planeOrientation, "ZX") == 0) limitedAxis = Axis::y;
+	else if (strcmp(planeOrientation, "Custom") == 0) limitedAxis = Axis::custom;
+	else if (strcmp(planeOrientation, "Bestfit") == 0) limitedAxis = Axis::bestFit;
+	return limitedAxis;
 }
-float
-DelaunayTriangulationSop::getLimitedValue(const Position* ptArr, size_t numPoints, Axis axis, LimitMode mode) {
-	float value = 0;
-	float average = 0;
 
-	if (mode == LimitMode::zero) {
+ProjectionPlane
+DelaunayTriangulationSop::getCustomPlane(const OP_Inputs* inputs) {
+	double origin[3];
+	double normal[3];
+	inputs->getParDouble3("Planeorigin", origin[0], origin[1], origin[2]);
+	inputs->getParDouble3("Planenormal", normal[0], normal[1], normal[2]);
+
+	const float originValues[3] = { static_cast<float>(origin[0]), static_cast<float>(origin[1]), static_cast<float>(origin[2]) };
+	const float normalValues[3] = { static_cast<float>(normal[0]), static_cast<float>(normal[1]), static_cast<float>(normal[2]) };
+
+	ProjectionPlane plane;
+	makePlane(originValues, normalValues, plane);
+	return plane;
+}
+
+DelaunayTriangulationSop::LimitMode
+DelaunayTriangulationSop::getLimitMode(const OP_Inputs* inputs) {
+	// get how we will limit the axis to put all the points on the same plane
+	const char* limitMethod = inputs->getParString("Limitmode");
+
+	LimitMode limitMode = LimitMode::min;
+	if (strcmp(limitMethod, "Min") == 0) limitMode = LimitMode::min;
+	else if (strcmp(limitMethod, "Center") == 0) limitMode = LimitMode::center;
+	else if (strcmp(limitMethod, "Max") == 0) limitMode = LimitMode::max;
+	else if (strcmp(limitMethod, "Zero") == 0) limitMode = LimitMode::zero;
+	else if (strcmp(limitMethod, "Original") == 0) limitMode = LimitMode::original;
+	return limitMode;
+}
+
+DelaunayTriangulationSop::Engine
+DelaunayTriangulationSop::getEngine(const OP_Inputs* inputs) {
+	// get which algorithm will do the triangulation
+	const char* engineName = inputs->getParString("Engine");
+
+	Engine engine = Engine::sweepHull;
+	if (strcmp(engineName, "Sweephull") == 0) engine = Engine::sweepHull;
+	else if (strcmp(engineName, "Divideandconquer") == 0) engine = Engine::divideAndConquer;
+	return engine;
+}
+
+DelaunayTriangulationSop::OutputMode
+DelaunayTriangulationSop::getOutputMode(const OP_Inputs* inputs) {
+	// get what we build from the triangulation
+	const char* outputName = inputs->getParString("Outputmode");
+
+	OutputMode outputMode = OutputMode::triangles;
+	if (strcmp(outputName, "Triangles") == 0) outputMode = OutputMode::triangles;
+	else if (strcmp(outputName, "Voronoi") == 0) outputMode = OutputMode::voronoi;
+	else if (strcmp(outputName, "Hull") == 0) outputMode = OutputMode::hull;
+	else if (strcmp(outputName, "Boundary") == 0) outputMode = OutputMode::boundary;
+	return outputMode;
+}
+
+TriangleCulling::Mode
+DelaunayTriangulationSop::getCullMode(const OP_Inputs* inputs) {
+	// get which triangles are too large to be output
+	const char* cullName = inputs->getParString("Cullmode");
+
+	TriangleCulling::Mode cullMode = TriangleCulling::none;
+	if (strcmp(cullName, "None") == 0) cullMode = TriangleCulling::none;
+	else if (strcmp(cullName, "Edgelength") == 0) cullMode = TriangleCulling::edgeLength;
+	else if (strcmp(cullName, "Circumradius") == 0) cullMode = TriangleCulling::circumradius;
+	return cullMode;
+}
+
+DelaunayTriangulationSop::PartitionMode
+DelaunayTriangulationSop::getPartitionMode(const OP_Inputs* inputs) {
+	// get how the points are split in separate triangulations
+	const char* partitionName = inputs->getParString("Triangulateper");
+
+	PartitionMode partitionMode = PartitionMode::all;
+	if (strcmp(partitionName, "All") == 0) partitionMode = PartitionMode::all;
+	else if (strcmp(partitionName, "Primitive") == 0) partitionMode = PartitionMode::primitive;
+	else if (strcmp(partitionName, "Attribute") == 0) partitionMode = PartitionMode::attribute;
+	return partitionMode;
+}
+
+float
+DelaunayTriangulationSop::getLimitedValue(Axis limitedAxis, LimitMode mode) {
+	// the stats of the input were gathered while projecting the points,
+	// in the frame of the plane for the arbitrary planes
+	const ProjectionStats& stats = myInputStats;
+	if (stats.numPoints == 0) {
 		return 0.0f;
 	}
-	
-	// convert the position pointer to a float pointer
-	const float* positions = reinterpret_cast<const float*>(ptArr);
+	int axis = limitedAxis <= Axis::z ? limitedAxis : 2;
 
 	switch (mode) {
 
-		// find the smallest value for the specified axis
+		// the smallest value for the specified axis
 		case LimitMode::min:
-			value = positions[axis];
-			for (size_t i = axis; i < numPoints / 3; i += 3) {
-				value = std::min(positions[i], value);
-			}
-			break;
+			return stats.min[axis];
 
-		// find the average value for the specified axis
+		// the average value for the specified axis
 		case LimitMode::center:
-			for (size_t i = axis; i < numPoints / 3; i += 3) {
-				average += positions[i];
-			}
-			value = average / numPoints;
-			break;
+			return static_cast<float>(stats.sum[axis] / stats.numPoints);
 
-		// find the maximum value for the speficied axis
+		// the maximum value for the speficied axis
 		case LimitMode::max:
-			value = positions[axis];
-			for (size_t i = axis; i < numPoints / 3; i += 3) {
-				value = std::max(value, positions[i]);
-			}
-			break;
+			return stats.max[axis];
+
+		case LimitMode::zero:
+		case LimitMode::original:
+		default:
+			return 0.0f;
 	}
-	return value;
 }
 
-void DelaunayTriangulationSop::build2dCoordsVector(std::vector<double>& coords,
-												   const Position* ptArr,
-												   size_t numPoints,
-												   Axis limitedAxis) {
-	// convert the position pointer to a float pointer
-	const float* positions = reinterpret_cast<const float*>(ptArr);
+BoundingBox
+DelaunayTriangulationSop::getOutputBounds(Axis limitedAxis, LimitMode mode, float limitedValue) {
+	const ProjectionStats& stats = myInputStats;
+
+	// every output point lies on the plane, unless they keep their original position
+	int axis = limitedAxis <= Axis::z ? limitedAxis : 2;
+	float low = mode == LimitMode::original ? stats.min[axis] : limitedValue;
+	float high = mode == LimitMode::original ? stats.max[axis] : limitedValue;
+
+	// the points of an arbitrary plane are inside the box of their bounds in the frame of the plane
+	if (limitedAxis > Axis::z) {
+		Position corner = build3dPosition(stats.min[0], stats.min[1], limitedAxis, low);
+		BoundingBox bbox(corner, corner);
+		for (int i = 1; i < 8; i++) {
+			bbox.enlargeBounds(build3dPosition((i & 1) ? stats.max[0] : stats.min[0],
+											   (i & 2) ? stats.max[1] : stats.min[1],
+											   limitedAxis, (i & 4) ? high : low));
+		}
+		return bbox;
+	}
+
+	float min[3] = { stats.min[0], stats.min[1], stats.min[2] };
+	float max[3] = { stats.max[0], stats.max[1], stats.max[2] };
+	min[axis] = low;
+	max[axis] = high;
+	return BoundingBox(min[0], min[1], min[2], max[0], max[1], max[2]);
+}
+
+Position
+DelaunayTriangulationSop::build3dPosition(float u, float v, Axis limitedAxis, float limitedValue) {
+	// put back the limited axis in between the two coordinates of the plane
+	switch (limitedAxis) {
+
+	case Axis::x:
+		return Position(limitedValue, u, v);
 
-	size_t j = 0;
-	for (size_t i = 0; i < numPoints * 3; i++) {
+	case Axis::y:
+		return Position(u, limitedValue, v);
 
-		// we need to skip the value of the axis we limit
-		if ((i % 3) == limitedAxis) {
+	case Axis::custom:
+	case Axis::bestFit:
+	{
+		const ProjectionPlane& plane = myPlane;
+		return Position(plane.origin[0] + u * plane.u[0] + v * plane.v[0] + limitedValue * plane.normal[0],
+						plane.origin[1] + u * plane.u[1] + v * plane.v[1] + limitedValue * plane.normal[1],
+						plane.origin[2] + u * plane.u[2] + v * plane.v[2] + limitedValue * plane.normal[2]);
+	}
+
+	case Axis::z:
+	default:
+		return Position(u, v, limitedValue);
+	}
+}
+
+void
+DelaunayTriangulationSop::beginCook(const OP_Inputs* inputs) {
+	// a new file when the path changes, a path that failed is only tried again once changed
+	const char* tracePath = inputs->getParInt("Trace") != 0 ? inputs->getParFilePath("Tracefile") : "";
+	if (!tracePath || !*tracePath) {
+		myTrace.stop();
+		myTracePath.clear();
+		myTraceWarning.clear();
+	} else if (myTracePath != tracePath) {
+		myTracePath = tracePath;
+		myTraceWarning.clear();
+		myTrace.start(tracePath, myTraceWarning);
+	} else if (myTrace.hasFailed()) {
+		myTraceWarning = "The trace file couldn't be written";
+	}
+	CookTrace::setCurrent(myTrace.isTracing() ? &myTrace : nullptr);
+
+	myTimings.beginCook();
+	myNumInputPoints = 0;
+	myNumOutputPoints = 0;
+	myNumOutputTriangles = 0;
+	myCookCacheHits = myCacheHits;
+	myCookCacheMisses = myCacheMisses;
+	myThreadPool.setMaxThreads(static_cast<unsigned>(std::max(0, inputs->getParInt("Maxthreads"))));
+	myFrame = inputs->getTimeInfo()->absFrame;
+
+	if (myCaptureRequested) {
+		myCaptureRequested = false;
+		myCaptureWarning.clear();
+		if (!myCapture.start(inputs->getParFilePath("Capturefile"), inputs->getParInt("Capturecooks"), myCaptureWarning)) {
+			return;
+		}
+	}
+	if (!myCapture.record(inputs, CapturedParameters, sizeof(CapturedParameters) / sizeof(CapturedParameters[0]))) {
+		myCaptureWarning = "The capture file couldn't be written";
+	}
+}
+
+void
+DelaunayTriangulationSop::endCook() {
+	myTimings.endCook();
+
+	CookHistory::Record record;
+	record.frame = myFrame;
+	record.inputPoints = static_cast<uint32_t>(myNumInputPoints);
+	record.outputTriangles = static_cast<uint32_t>(myNumOutputTriangles);
+	record.hullSize = myHasTriangulation ? static_cast<uint32_t>(myTriangulationCounts.hullSize) : 0;
+	record.duplicates = myHasTriangulation ? static_cast<uint32_t>(myTriangulationCounts.numUnusedPoints) : 0;
+	record.cache = myCacheMisses != myCookCacheMisses ? CookHistory::Cache::miss :
+		myCacheHits != myCookCacheHits ? CookHistory::Cache::hit : CookHistory::Cache::none;
+	for (int stage = 0; stage < CookTimings::NumStages; stage++) {
+		record.stageMs[stage] = static_cast<float>(myTimings.getSummary(static_cast<CookTimings::Stage>(stage)).last);
+	}
+	record.peakMemory = myCookMemory;
+	myHistory.record(record);
+
+	CookTrace::setCurrent(nullptr);
+}
+
+void
+DelaunayTriangulationSop::build3dPositions(Position* positions, Axis limitedAxis, float limitedValue) {
+	const std::vector<float>& coords = myCoords;
+	const std::size_t numPoints = coords.size() / 2;
+	const std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(myThreadPool.getNumThreads() * 4, numPoints / MinChunkSize));
+	myThreadPool.parallelFor(numChunks, [&](std::size_t chunk) {
+		for (std::size_t i = numPoints * chunk / numChunks; i < numPoints * (chunk + 1) / numChunks; i++) {
+			positions[i] = build3dPosition(coords[2 * i], coords[2 * i + 1], limitedAxis, limitedValue);
+		}
+	});
+}
+
+void
+DelaunayTriangulationSop::triangulate(const std::vector<float>& coords, Engine engine, Triangulation& triangulation) {
+	switch (engine) {
+
+	case Engine::divideAndConquer:
+		myDivideAndConquer.triangulate(coords, myThreadPool, triangulation);
+		break;
+
+	case Engine::sweepHull:
+	default:
+		mySweepHull.triangulate(coords, triangulation);
+		break;
+	}
+}
+
+void
+DelaunayTriangulationSop::gatherEdges(const OP_SOPInput* sinput, bool closedOnly, std::vector<int32_t>& edges) {
+	// every polygon is closed, a polygon of two points is a single edge
+	edges.clear();
+	int32_t numPrimitives = sinput->getNumPrimitives();
+	for (int32_t i = 0; i < numPrimitives; i++) {
+		const SOP_PrimitiveInfo primitive = sinput->getPrimitive(i);
+		int32_t numVertices = primitive.numVertices;
+		if (closedOnly && numVertices < 3) {
 			continue;
 		}
+		int32_t numEdges = numVertices > 2 ? numVertices : numVertices - 1;
+		for (int32_t j = 0; j < numEdges; j++) {
+			edges.push_back(primitive.pointIndices[j]);
+			edges.push_back(primitive.pointIndices[(j + 1) % numVertices]);
+		}
+	}
+}
+
+void
+DelaunayTriangulationSop::gatherPartitions(const OP_SOPInput* sinput, PartitionMode partitionMode, const char* attributeName) {
+	size_t numPoints = static_cast<size_t>(sinput->getNumPoints());
+	myPartitions.assign(numPoints, PartitionedDelaunay::NoPartition);
+	myNumPartitions = 0;
+
+	if (partitionMode == PartitionMode::primitive) {
+		// a point used by several primitives goes with the first one, the points of no primitive are left out
+		int32_t numPrimitives = sinput->getNumPrimitives();
+		for (int32_t i = 0; i < numPrimitives; i++) {
+			const SOP_PrimitiveInfo primitive = sinput->getPrimitive(i);
+			for (int32_t j = 0; j < primitive.numVertices; j++) {
+				uint32_t& partition = myPartitions[primitive.pointIndices[j]];
+				if (partition == PartitionedDelaunay::NoPartition) {
+					partition = static_cast<uint32_t>(i);
+				}
+			}
+		}
+		myNumPartitions = static_cast<uint32_t>(numPrimitives);
+	} else if (partitionMode == PartitionMode::attribute) {
+		// every value of the first component is a partition, float values are rounded
+		const SOP_CustomAttribData* attribute = sinput->getCustomAttribute(attributeName);
+		if (!attribute) {
+			myWarning = std::string("Partition attribute ") + attributeName + " not found";
+			return;
+		}
+		myPartitionOfValue.clear();
+		for (size_t i = 0; i < numPoints; i++) {
+			int32_t value = attribute->attribType == AttribType::Int ? attribute->intData[i * attribute->numComponents] :
+				static_cast<int32_t>(lroundf(attribute->floatData[i * attribute->numComponents]));
+			// unlike emplace, a value already seen doesn't allocate a node
+			auto inserted = myPartitionOfValue.try_emplace(value, myNumPartitions);
+			if (inserted.second) {
+				myNumPartitions++;
+			}
+			myPartitions[i] = inserted.first->second;
+		}
+	}
+}
+
+uint64_t
+DelaunayTriangulationSop::hashInput(const Position* positions, size_t numPoints, Axis limitedAxis, const ProjectionPlane& customPlane) {
+	uint64_t settings = static_cast<uint64_t>(limitedAxis) << 8;
+	uint64_t seed = (numPoints << 16) ^ settings;
+	if (limitedAxis == Axis::custom) {
+		seed = hashBytes(&customPlane, sizeof(customPlane), seed);
+	}
+	return hashBytes(positions, numPoints * sizeof(Position), seed);
+}
+
+void
+DelaunayTriangulationSop::projectInput(const Position* positions, size_t numPoints, Axis limitedAxis, const ProjectionPlane& customPlane,
+									   std::vector<float>& coords, ProjectionPlane& plane, ProjectionStats& stats) {
+	const float* values = reinterpret_cast<const float*>(positions);
+	coords.resize(numPoints * 2);
+	if (limitedAxis == Axis::custom || limitedAxis == Axis::bestFit) {
+		if (limitedAxis == Axis::custom) {
+			plane = customPlane;
+		} else {
+			fitPlane(values, numPoints, myThreadPool, plane);
+		}
+		projectPointsOnPlane(values, numPoints, plane, myThreadPool, coords.data(), stats);
+	} else {
+		projectPoints(values, numPoints, limitedAxis, coords.data(), stats);
+	}
+}
+
+float
+DelaunayTriangulationSop::updateTriangulation(const OP_SOPInput* sinput, Axis limitedAxis, LimitMode limitMode, Engine engine,
+											  const ProjectionPlane& customPlane, bool constrained,
+											  PartitionMode partitionMode, const char* partitionAttribute, bool needTriangles,
+											  bool background, double budget) {
+	// the triangulation below and the job slices charge their own stage
+	CookTimings::Scope scope(myTimings, CookTimings::Stage::projection);
+	myNumInputPoints = sinput->getNumPoints();
+	myWarning.clear();
+	if (background || budget > 0.0) {
+		return updateBackgroundTriangulation(sinput, limitedAxis, limitMode, engine, customPlane, constrained,
+											 partitionMode, partitionAttribute, needTriangles, background, budget);
+	}
+	myBackgroundPending = false;
+
+	// the result is of this cook's input from here on, not of a job
+	myResultFrame = -1;
+
+	// get the position of the points
+	const Position* ptArr = sinput->getPointPositions();
+	size_t numPoints = static_cast<size_t>(sinput->getNumPoints());
+
+	// upstream nodes often cook without moving their points, in which case
+	// everything we computed last time is still valid
+	uint64_t inputHash = hashInput(ptArr, numPoints, limitedAxis, customPlane);
+
+	if (myHasCoords && inputHash == myInputHash) {
+		myCacheHits++;
+	} else {
+		myCacheMisses++;
+		myInputHash = inputHash;
+
+		// generate the array of 2d point we will triangulate, and the stats
+		// of the limited axis in the same pass
+		projectInput(ptArr, numPoints, limitedAxis, customPlane, myNewCoords, myPlane, myInputStats);
+
+		// the triangles only depend on the 2d points, so when the points only
+		// moved along the limited axis we can keep them
+		if (!(myHasCoords && myNewCoords == myCoords)) {
+			myCoords.swap(myNewCoords);
+			myHasCoords = true;
+			myHasTriangulation = false;
+		}
+	}
+
+	// the primitives can change without the points moving
+	uint64_t constraintHash = 0;
+	if (constrained) {
+		gatherEdges(sinput, false, myConstraintEdges);
+		constraintHash = hashBytes(myConstraintEdges.data(), myConstraintEdges.size() * sizeof(int32_t), 1);
+	}
+
+	uint64_t partitionHash = 0;
+	if (partitionMode != PartitionMode::all) {
+		gatherPartitions(sinput, partitionMode, partitionAttribute);
+		partitionHash = hashBytes(myPartitions.data(), myPartitions.size() * sizeof(uint32_t), partitionMode);
+	}
+
+	if (needTriangles && !(myHasTriangulation && engine == myTriangulationEngine &&
+						   constraintHash == myConstraintHash && partitionHash == myPartitionHash)) {
+		CookTimings::Scope scope(myTimings, CookTimings::Stage::triangulation);
+		myHasTriangulation = false;
+		if (partitionMode != PartitionMode::all) {
+			myPartitioned.triangulate(myCoords, myPartitions, myNumPartitions, engine == Engine::divideAndConquer,
+									  myThreadPool, myTriangulation);
+		} else {
+			triangulate(myCoords, engine, myTriangulation);
+		}
+		if (constrained) {
+			myConstrained.constrain(myCoords, myConstraintEdges, myTriangulation);
+		}
+		countTriangulation(myTriangulation, myCoords.size() / 2, myUsedPoints, myTriangulationCounts);
+		myTriangulationEngine = engine;
+		myConstraintHash = constraintHash;
+		myPartitionHash = partitionHash;
+		myResultSkipped = constrained ? myConstrained.getNumSkipped() : 0;
+		myHasTriangulation = true;
+	}
+	return getLimitedValue(limitedAxis, limitMode);
+}
+
+float
+DelaunayTriangulationSop::updateBackgroundTriangulation(const OP_SOPInput* sinput, Axis limitedAxis, LimitMode limitMode, Engine engine,
+														const ProjectionPlane& customPlane, bool constrained,
+														PartitionMode partitionMode, const char* partitionAttribute,
+														bool needTriangles, bool threaded, double budget) {
+	// the budget starts with the triangulation, a job in the background ignores it
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+	if (!threaded) {
+		deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double, std::milli>(budget));
+	}
+
+	const Position* ptArr = sinput->getPointPositions();
+	size_t numPoints = static_cast<size_t>(sinput->getNumPoints());
+	uint64_t inputHash = hashInput(ptArr, numPoints, limitedAxis, customPlane);
+
+	// without triangles the job only projects the points, whatever the settings of the triangulation
+	uint64_t constraintHash = 0;
+	if (needTriangles && constrained) {
+		gatherEdges(sinput, false, myConstraintEdges);
+		constraintHash = hashBytes(myConstraintEdges.data(), myConstraintEdges.size() * sizeof(int32_t), 1);
+	}
+
+	uint64_t partitionHash = 0;
+	if (needTriangles && partitionMode != PartitionMode::all) {
+		gatherPartitions(sinput, partitionMode, partitionAttribute);
+		partitionHash = hashBytes(myPartitions.data(), myPartitions.size() * sizeof(uint32_t), partitionMode);
+	}
+
+	const uint64_t hashes[] = { inputHash, constraintHash, partitionHash,
+								needTriangles ? static_cast<uint64_t>(engine) : std::numeric_limits<uint64_t>::max() };
+	uint64_t hash = hashBytes(hashes, sizeof(hashes), 2);
+
+	// a triangulation of the cook path, from before the background was turned on, is kept
+	// when it is of this input, with a copy of the positions for once the input changes.
+	// One of another input has no positions left to show it with.
+	if (myResultFrame < 0 && myHasCoords) {
+		if (inputHash == myInputHash && (!needTriangles || (myHasTriangulation && constraintHash == myConstraintHash &&
+															 partitionHash == myPartitionHash && engine == myTriangulationEngine))) {
+			myResultPositions.assign(ptArr, ptArr + numPoints);
+			myResultHash = hash;
+			myResultFrame = myFrame;
+		} else {
+			myHasCoords = false;
+			myHasTriangulation = false;
+			myCoords.clear();
+			myTriangulation.triangles.clear();
+			myTriangulation.halfedges.clear();
+			myInputStats = ProjectionStats();
+		}
+	}
+
+	{
+		CookTimings::Scope scope(myTimings, CookTimings::Stage::triangulation);
+		myBackground.resume(deadline);
+	}
+	if (myBackground.isDone()) {
+		acceptBackgroundResult();
+	}
 
-		// add the values of the other axis to the vector
-		coords[j] = positions[i];
-		j++;
+	// the points of a triangulation do for the hull as well
+	auto isShown = [&]() {
+		return myResultFrame >= 0 && (needTriangles ? hash == myResultHash : inputHash == myInputHash);
+	};
+
+	// a new input waits for the running job, the node cooks again to start it
+	if (isShown()) {
+		// the shown result is the triangulation of this cook's input
+		myCacheHits++;
+		myResultFrame = myFrame;
+	} else if (!myBackground.isRunning()) {
+		myCacheMisses++;
+		BackgroundTriangulation::Job& job = myBackground.getJob();
+		BackgroundInput& input = myBackgroundInput;
+		projectInput(ptArr, numPoints, limitedAxis, customPlane, job.coords, input.plane, input.stats);
+		input.positions.assign(ptArr, ptArr + numPoints);
+
+		// the gathered buffers go to the job, and get the ones of the last job to fill next
+		job.needTriangles = needTriangles;
+		job.constrained = needTriangles && constrained;
+		job.constraintEdges.swap(myConstraintEdges);
+		job.partitioned = needTriangles && partitionMode != PartitionMode::all;
+		job.partitions.swap(myPartitions);
+		job.numPartitions = myNumPartitions;
+		job.divideAndConquer = engine == Engine::divideAndConquer;
+		job.maxThreads = myThreadPool.getNumThreads();
+
+		input.hash = hash;
+		input.inputHash = inputHash;
+		input.constraintHash = constraintHash;
+		input.partitionHash = partitionHash;
+		input.engine = engine;
+		input.frame = myFrame;
+		if (threaded && needTriangles) {
+			myBackground.start();
+		} else {
+			// a small input can be done within the budget of this cook, the points alone always are
+			CookTimings::Scope scope(myTimings, CookTimings::Stage::triangulation);
+			myBackground.startSliced();
+			myBackground.resume(deadline);
+			if (myBackground.isDone()) {
+				acceptBackgroundResult();
+			}
+		}
 	}
+
+	myBackgroundPending = myBackground.isRunning() || myBackground.isDone() || !isShown();
+	return getLimitedValue(limitedAxis, limitMode);
 }
 
+void
+DelaunayTriangulationSop::acceptBackgroundResult() {
+	// the shown result is newer when the input came back to it while the job ran,
+	// or when it was made by the cook path after the job started
+	BackgroundTriangulation::Job& job = myBackground.getJob();
+	BackgroundInput& input = myBackgroundInput;
+	if (myResultFrame >= 0 && input.frame < myResultFrame) {
+		myBackground.acceptResult();
+		return;
+	}
+
+	// the finished job becomes the shown result, and gets its buffers to fill next
+	myCoords.swap(job.coords);
+	myTriangulation.triangles.swap(job.triangulation.triangles);
+	myTriangulation.halfedges.swap(job.triangulation.halfedges);
+	myResultPositions.swap(input.positions);
+	myResultSkipped = job.numSkipped;
+	myTriangulationCounts = job.counts;
+	myResultFrame = input.frame;
+	myResultHash = input.hash;
+	myInputStats = input.stats;
+	myPlane = input.plane;
+
+	// the result is as good as a triangulation done in the cook
+	myInputHash = input.inputHash;
+	myConstraintHash = input.constraintHash;
+	myPartitionHash = input.partitionHash;
+	myTriangulationEngine = input.engine;
+	myHasCoords = true;
+	myHasTriangulation = job.needTriangles;
+	myBackground.acceptResult();
+}
+
+const Position*
+DelaunayTriangulationSop::getInputPositions(const OP_SOPInput* sinput) {
+	// the input may have changed since the job was started
+	return myResultFrame >= 0 ? myResultPositions.data() : sinput->getPointPositions();
+}
+
+bool
+DelaunayTriangulationSop::updateMask(const OP_Inputs* inputs, Axis limitedAxis) {
+	const OP_SOPInput* mask = inputs->getNumInputs() > 1 ? inputs->getInputSOP(1) : nullptr;
+	if (!mask) {
+		return false;
+	}
+
+	gatherEdges(mask, true, myMaskEdges);
+	const Position* maskPositions = mask->getPointPositions();
+	size_t numPoints = static_cast<size_t>(mask->getNumPoints());
+
+	// the mask goes on the same plane as the points, so it moves with the plane
+	uint64_t seed = hashBytes(myMaskEdges.data(), myMaskEdges.size() * sizeof(int32_t), static_cast<uint64_t>(limitedAxis));
+	if (limitedAxis == Axis::custom || limitedAxis == Axis::bestFit) {
+		seed = hashBytes(&myPlane, sizeof(myPlane), seed);
+	}
+	uint64_t maskHash = hashBytes(maskPositions, numPoints * sizeof(Position), seed);
+	if (myHasMask && maskHash == myMaskHash) {
+		return true;
+	}
+
+	const float* positions = reinterpret_cast<const float*>(maskPositions);
+	ProjectionStats stats;
+	myMaskCoords.resize(numPoints * 2);
+	if (limitedAxis == Axis::custom || limitedAxis == Axis::bestFit) {
+		projectPointsOnPlane(positions, numPoints, myPlane, myThreadPool, myMaskCoords.data(), stats);
+	} else {
+		projectPoints(positions, numPoints, limitedAxis, myMaskCoords.data(), stats);
+	}
+	myMask.build(myMaskCoords, myMaskEdges);
+	myMaskHash = maskHash;
+	myHasMask = true;
+	return true;
+}
+
+const std::vector<std::size_t>&
+DelaunayTriangulationSop::cullTriangles(const OP_Inputs* inputs, Axis limitedAxis) {
+	CookTimings::Scope scope(myTimings, CookTimings::Stage::conversion);
+	const uint8_t* removed = nullptr;
+	if (updateMask(inputs, limitedAxis)) {
+		bool removeInside = strcmp(inputs->getParString("Maskmode"), "Holes") == 0;
+		removed = myMask.classify(myCoords, myTriangulation, removeInside, myThreadPool).data();
+	}
+
+	// the threshold is a length in the plane of the triangulation
+	float threshold = static_cast<float>(inputs->getParDouble("Cullthreshold"));
+	return myCulling.cull(myCoords, myTriangulation, getCullMode(inputs), threshold, removed, myThreadPool);
+}
+
+size_t
+DelaunayTriangulationSop::getMemoryUsage() const {
+	return mySweepHull.getMemoryUsage() + myDivideAndConquer.getMemoryUsage() + myConstrained.getMemoryUsage() +
+		myPartitioned.getMemoryUsage() + myBackground.getMemoryUsage() + myMask.getMemoryUsage() +
+		myVoronoi.getMemoryUsage() + myConvexHull.getMemoryUsage() +
+		myCulling.getMemoryUsage() + myBoundary.getMemoryUsage() +
+		(myCoords.capacity() + myNewCoords.capacity() + myMaskCoords.capacity()) * sizeof(float) +
+		(myConstraintEdges.capacity() + myMaskEdges.capacity()) * sizeof(int32_t) +
+		myPartitions.capacity() * sizeof(uint32_t) + myUsedPoints.capacity() * sizeof(uint8_t) +
+		(myTriangulation.triangles.capacity() + myTriangulation.halfedges.capacity()) * sizeof(size_t) +
+		(myOutputPositions.capacity() + myResultPositions.capacity() + myBackgroundInput.positions.capacity()) * sizeof(Position) +
+		(myOutputIndices.capacity() + myOutputLineSizes.capacity()) * sizeof(int32_t);
+}
+
+size_t
+DelaunayTriangulationSop::getResultMemoryUsage() const {
+	// the positions of a job are only used while its result is shown
+	return myMask.getMemoryUsage() +
+		myCoords.capacity() * sizeof(float) +
+		(myTriangulation.triangles.capacity() + myTriangulation.halfedges.capacity()) * sizeof(size_t) +
+		(myResultFrame >= 0 ? myResultPositions.capacity() * sizeof(Position) : 0);
+}
+
+void
+DelaunayTriangulationSop::trimMemory(const OP_Inputs* inputs) {
+	size_t maxBytes = static_cast<size_t>(std::max(0, inputs->getParInt("Maxretainedmemory"))) << 20;
+	myCookMemory = getMemoryUsage();
+	if (myCookMemory - getResultMemoryUsage() <= maxBytes) {
+		return;
+	}
+
+	// let go of the buffers which are only needed during a cook
+	mySweepHull.releaseMemory();
+	myDivideAndConquer.releaseMemory();
+	myConstrained.releaseMemory();
+	myPartitioned.releaseMemory();
+	myBackground.releaseMemory();
+	myVoronoi.releaseMemory();
+	myConvexHull.releaseMemory();
+	myCulling.releaseMemory();
+	myBoundary.releaseMemory();
+	std::vector<float>().swap(myNewCoords);
+	std::vector<uint8_t>().swap(myUsedPoints);
+	std::vector<Position>().swap(myOutputPositions);
+	std::vector<int32_t>().swap(myOutputIndices);
+	std::vector<int32_t>().swap(myOutputLineSizes);
+	std::vector<int32_t>().swap(myConstraintEdges);
+	std::vector<uint32_t>().swap(myPartitions);
+	std::vector<float>().swap(myMaskCoords);
+	std::vector<int32_t>().swap(myMaskEdges);
+	if (myResultFrame < 0) {
+		std::vector<Position>().swap(myResultPositions);
+	}
+}
+
+void
+DelaunayTriangulationSop::outputVoronoi(SOP_Output* output, const OP_Inputs* inputs, Axis limitedAxis, LimitMode limitMode, float limitedValue) {
+	// the cells are clipped to the bounds of the points, grown by the padding
+	const ProjectionStats& stats = myInputStats;
+	if (stats.numPoints == 0) {
+		return;
+	}
+	int uAxis = 0;
+	int vAxis = 1;
+	if (limitedAxis <= Axis::z) {
+		// the stats are in world space, keep the two axes of the plane
+		uAxis = limitedAxis == Axis::x ? 1 : 0;
+		vAxis = limitedAxis == Axis::z ? 1 : 2;
+	}
+	float padding = static_cast<float>(inputs->getParDouble("Voronoipadding"));
+	float bounds[4] = { stats.min[uAxis] - padding, stats.min[vAxis] - padding, stats.max[uAxis] + padding, stats.max[vAxis] + padding };
+
+	// the diagram has no original coordinate to keep, it goes through the center instead
+	if (limitMode == LimitMode::original) {
+		limitedValue = getLimitedValue(limitedAxis, LimitMode::center);
+	}
+
+	myVoronoi.build(myCoords, myTriangulation, bounds, myThreadPool);
+	const std::vector<float>& vertices = myVoronoi.getVertices();
+	const std::vector<int32_t>& edges = myVoronoi.getEdges();
+	if (edges.empty()) {
+		return;
+	}
+
+	std::vector<Position>& positions = myOutputPositions;
+	positions.resize(vertices.size() / 2);
+	for (std::size_t i = 0; i < positions.size(); i++) {
+		positions[i] = build3dPosition(vertices[2 * i], vertices[2 * i + 1], limitedAxis, limitedValue);
+	}
+	CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+	output->addPoints(positions.data(), static_cast<int32_t>(positions.size()));
+
+	// every edge is a line of its own
+	myOutputLineSizes.assign(edges.size() / 2, 2);
+	output->addLines(edges.data(), myOutputLineSizes.data(), static_cast<int32_t>(myOutputLineSizes.size()));
+
+	Position corner = build3dPosition(bounds[0], bounds[1], limitedAxis, limitedValue);
+	BoundingBox bbox(corner, corner);
+	bbox.enlargeBounds(build3dPosition(bounds[2], bounds[1], limitedAxis, limitedValue));
+	bbox.enlargeBounds(build3dPosition(bounds[0], bounds[3], limitedAxis, limitedValue));
+	bbox.enlargeBounds(build3dPosition(bounds[2], bounds[3], limitedAxis, limitedValue));
+	output->setBoundingBox(bbox);
+}
+
+void
+DelaunayTriangulationSop::outputHull(SOP_Output* output, const Position* inputPositions, Axis limitedAxis, LimitMode limitMode, float limitedValue) {
+	myConvexHull.build(myCoords, myThreadPool);
+	const std::vector<uint32_t>& hullIndices = myConvexHull.getIndices();
+	if (hullIndices.size() < 2) {
+		return;
+	}
+
+	// only the points of the hull are emitted
+	std::vector<Position>& positions = myOutputPositions;
+	positions.resize(hullIndices.size());
+	for (std::size_t i = 0; i < hullIndices.size(); i++) {
+		uint32_t point = hullIndices[i];
+		positions[i] = limitMode == LimitMode::original ? inputPositions[point] :
+			build3dPosition(myCoords[2 * point], myCoords[2 * point + 1], limitedAxis, limitedValue);
+	}
+	CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+	output->addPoints(positions.data(), static_cast<int32_t>(positions.size()));
+
+	// the line goes back to its first point to be closed, unless the points are aligned
+	std::vector<int32_t>& indices = myOutputIndices;
+	indices.resize(positions.size());
+	for (std::size_t i = 0; i < indices.size(); i++) {
+		indices[i] = static_cast<int32_t>(i);
+	}
+	if (indices.size() > 2) {
+		indices.push_back(0);
+	}
+	output->addLine(indices.data(), static_cast<int32_t>(indices.size()));
+
+	BoundingBox bbox(positions[0], positions[0]);
+	for (std::size_t i = 1; i < positions.size(); i++) {
+		bbox.enlargeBounds(positions[i]);
+	}
+	output->setBoundingBox(bbox);
+}
+
+void
+DelaunayTriangulationSop::outputBoundary(SOP_Output* output, const OP_Inputs* inputs, const Position* inputPositions, Axis limitedAxis, LimitMode limitMode, float limitedValue) {
+	cullTriangles(inputs, limitedAxis);
+	myBoundary.build(myTriangulation, myCulling.getKeptMask());
+	const std::vector<int32_t>& loopIndices = myBoundary.getIndices();
+	const std::vector<int32_t>& loopSizes = myBoundary.getSizes();
+	if (loopSizes.empty()) {
+		return;
+	}
+
+	// only the points of the loops are emitted, a point touching two loops once per loop
+	std::vector<Position>& positions = myOutputPositions;
+	std::vector<int32_t>& indices = myOutputIndices;
+	positions.clear();
+	indices.clear();
+	std::size_t loopStart = 0;
+	for (int32_t size : loopSizes) {
+		const int32_t first = static_cast<int32_t>(positions.size());
+		for (std::size_t i = loopStart; i < loopStart + size - 1; i++) {
+			int32_t point = loopIndices[i];
+			indices.push_back(static_cast<int32_t>(positions.size()));
+			positions.push_back(limitMode == LimitMode::original ? inputPositions[point] :
+				build3dPosition(myCoords[2 * point], myCoords[2 * point + 1], limitedAxis, limitedValue));
+		}
+		indices.push_back(first);
+		loopStart += size;
+	}
+	CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+	output->addPoints(positions.data(), static_cast<int32_t>(positions.size()));
+	myOutputLineSizes.assign(loopSizes.begin(), loopSizes.end());
+	output->addLines(indices.data(), myOutputLineSizes.data(), static_cast<int32_t>(myOutputLineSizes.size()));
+
+	BoundingBox bbox(positions[0], positions[0]);
+	for (std::size_t i = 1; i < positions.size(); i++) {
+		bbox.enlargeBounds(positions[i]);
+	}
+	output->setBoundingBox(bbox);
+}
 
 void
 DelaunayTriangulationSop::execute(SOP_Output* output, const OP_Inputs* inputs, void* reserved)
 {
 
+	beginCook(inputs);
+
 	if (inputs->getNumInputs() > 0)
 	{
 		// get the sop connected to the first input
 		const OP_SOPInput	*sinput = inputs->getInputSOP(0);
 
-		// get the position of the points
-		const Position* ptArr = sinput->getPointPositions();
-
-		// get the orientation of the plane on which we will project the points on
-		const char* planeOrientation = inputs->getParString("Planeorientation");
-
 		// store wich axis we will limit to create the place
-		Axis limitedAxis = limitedAxis = Axis::z;
-		if (strcmp(planeOrientation, "XY") == 0) limitedAxis = Axis::z;
-		else if (strcmp(planeOrientation, "YZ") == 0) limitedAxis = Axis::x;
-		else if (strcmp(planeOrientation, "ZX") == 0) limitedAxis = Axis::y;
-
-		// get how we will limit the axis to put all the points on the same plane
-		const char* limitMethod = inputs->getParString("Limitmode");
+		Axis limitedAxis = getLimitedAxis(inputs);
 
 		// store the method to limit the position
-		LimitMode limitMode = LimitMode::min;
-		if (strcmp(limitMethod, "Min") == 0) limitMode = LimitMode::min;
-		else if (strcmp(limitMethod, "Center") == 0) limitMode = LimitMode::center;
-		else if (strcmp(limitMethod, "Max") == 0) limitMode = LimitMode::max;
-		else if (strcmp(limitMethod, "Zero") == 0) limitMode = LimitMode::zero;
-
-		// get the limited value for the selected axis
-		float limitedValue = getLimitedValue(ptArr,
-			                                 sinput->getNumPoints(),
-			                                 limitedAxis,
-			                                 limitMode);
-
-		// generate the array of 2d point we will triangulate
-		std::vector<double> coords(static_cast<size_t>(sinput->getNumPoints()) * 2);
-		build2dCoordsVector(coords, ptArr, sinput->getNumPoints(), limitedAxis);
-
-		// do the delaunay triangulation
-		delaunator::Delaunator delaunator(coords);
-
-		for (std::size_t i = 0; i < delaunator.triangles.size(); i += 3) {
-			Position pointPosA;
-			Position pointPosB;
-			Position pointPosC;
-
-			switch (limitedAxis) {
-
-			case Axis::x :
-				pointPosA = Position(limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i] + 1]));
-				pointPosB = Position(limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1] + 1]));
-				pointPosC = Position(limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2] + 1]));
-				break;
-
-			case Axis::y:
-				pointPosA = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i]]),
-					limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i] + 1]));
-				pointPosB = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1]]),
-					limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1] + 1]));
-				pointPosC = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2]]),
-					limitedValue,
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2] + 1]));
-				break;
-
-			case Axis::z:
-				pointPosA = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i] + 1]),
-					limitedValue);
-				pointPosB = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 1] + 1]),
-					limitedValue);
-				pointPosC = Position(static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2]]),
-					static_cast<float>(delaunator.coords[2 * delaunator.triangles[i + 2] + 1]),
-					limitedValue);
-				break;
+		LimitMode limitMode = getLimitMode(inputs);
+
+		OutputMode outputMode = getOutputMode(inputs);
+
+		// do the delaunay triangulation, unless the input is the same as the last cook
+		float limitedValue = updateTriangulation(sinput, limitedAxis, limitMode, getEngine(inputs), getCustomPlane(inputs),
+												 inputs->getParInt("Constrained") != 0, getPartitionMode(inputs), inputs->getParString("Partitionattribute"),
+												 outputMode != OutputMode::hull, inputs->getParInt("Background") != 0, inputs->getParDouble("Cookbudget"));
+		const std::vector<float>& coords = myCoords;
+
+		// the output functions charge their writes to the output stage
+		CookTimings::Scope scope(myTimings, CookTimings::Stage::conversion);
+
+		// the input points, when they keep their original position
+		const Position* inputPositions = getInputPositions(sinput);
+		bool keepOriginal = limitMode == LimitMode::original;
+
+		if (outputMode == OutputMode::voronoi) {
+			outputVoronoi(output, inputs, limitedAxis, limitMode, limitedValue);
+		} else if (outputMode == OutputMode::hull) {
+			outputHull(output, inputPositions, limitedAxis, limitMode, limitedValue);
+		} else if (outputMode == OutputMode::boundary) {
+			outputBoundary(output, inputs, inputPositions, limitedAxis, limitMode, limitedValue);
+		} else if (inputs->getParInt("Sharedpoints")) {
+			const std::vector<std::size_t>& triangles = cullTriangles(inputs, limitedAxis);
+
+			// emit every input point once, projected on the plane
+			const Position* positions = inputPositions;
+			if (!keepOriginal) {
+				myOutputPositions.resize(coords.size() / 2);
+				build3dPositions(myOutputPositions.data(), limitedAxis, limitedValue);
+				positions = myOutputPositions.data();
 			}
 
-			int indexA = output->addPoint(pointPosA);
-			int indexB = output->addPoint(pointPosB);
-			int indexC = output->addPoint(pointPosC);
-			output->addTriangle(indexA, indexB, indexC);
+			// the triangles reference the input points directly
+			std::vector<int32_t>& indices = myOutputIndices;
+			indices.assign(triangles.begin(), triangles.end());
+
+			CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+			output->addPoints(positions, static_cast<int32_t>(coords.size() / 2));
+			output->addTriangles(indices.data(), static_cast<int32_t>(indices.size() / 3));
+		} else {
+			// the points are built as they are written, it all counts as output
+			const std::vector<std::size_t>& triangles = cullTriangles(inputs, limitedAxis);
+			CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+			for (std::size_t i = 0; i < triangles.size(); i += 3) {
+				int indices[3];
+				for (int k = 0; k < 3; k++) {
+					std::size_t point = triangles[i + k];
+					Position pointPos = keepOriginal ? inputPositions[point] :
+						build3dPosition(coords[2 * point], coords[2 * point + 1], limitedAxis, limitedValue);
+					indices[k] = output->addPoint(pointPos);
+				}
+				output->addTriangle(indices[0], indices[1], indices[2]);
+			}
 		}
+
+		if (!coords.empty() && outputMode == OutputMode::triangles) {
+			output->setBoundingBox(getOutputBounds(limitedAxis, limitMode, limitedValue));
+		}
+		myNumOutputPoints = output->getNumPoints();
+		myNumOutputTriangles = outputMode == OutputMode::triangles ? output->getNumPrimitives() : 0;
+
+		trimMemory(inputs);
 	}
+
+	endCook();
 }
 
 void
@@ -260,6 +1072,57 @@ DelaunayTriangulationSop::executeVBO(SOP_VBOOutput* output,
 						const OP_Inputs* inputs,
 						void* reserved)
 {
+	beginCook(inputs);
+
+	if (inputs->getNumInputs() > 0)
+	{
+		// get the sop connected to the first input
+		const OP_SOPInput	*sinput = inputs->getInputSOP(0);
+
+		Axis limitedAxis = getLimitedAxis(inputs);
+		LimitMode limitMode = getLimitMode(inputs);
+
+		// do the delaunay triangulation, unless the input is the same as the last cook
+		float limitedValue = updateTriangulation(sinput, limitedAxis, limitMode, getEngine(inputs), getCustomPlane(inputs),
+												 inputs->getParInt("Constrained") != 0, getPartitionMode(inputs), inputs->getParString("Partitionattribute"),
+												 true, inputs->getParInt("Background") != 0, inputs->getParDouble("Cookbudget"));
+		const std::vector<std::size_t>& triangles = cullTriangles(inputs, limitedAxis);
+
+		int32_t numPoints = static_cast<int32_t>(myCoords.size() / 2);
+		int32_t numTriangles = static_cast<int32_t>(triangles.size() / 3);
+		myNumOutputPoints = numPoints;
+		myNumOutputTriangles = numTriangles;
+
+		// the points and indices are converted straight into the vbo
+		CookTimings::Scope scope(myTimings, CookTimings::Stage::output);
+
+		// the vbo always shares the points between the triangles
+		output->allocVBO(numPoints, numTriangles * 3, VBOBufferMode::Dynamic);
+
+		// write the projected points straight into the vbo
+		Position* positions = output->getPos();
+		if (limitMode == LimitMode::original) {
+			const Position* inputPositions = getInputPositions(sinput);
+			std::copy(inputPositions, inputPositions + numPoints, positions);
+		} else {
+			build3dPositions(positions, limitedAxis, limitedValue);
+		}
+
+		int32_t* indices = output->addTriangles(numTriangles);
+		for (std::size_t i = 0; i < triangles.size(); i++) {
+			indices[i] = static_cast<int32_t>(triangles[i]);
+		}
+
+		if (numPoints > 0) {
+			output->setBoundingBox(getOutputBounds(limitedAxis, limitMode, limitedValue));
+		}
+
+		output->updateComplete();
+
+		trimMemory(inputs);
+	}
+
+	endCook();
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -270,20 +1133,84 @@ int32_t
 DelaunayTriangulationSop::getNumInfoCHOPChans(void* reserved)
 {
 	// We return the number of channel we want to output to any Info CHOP
-	// connected to the CHOP. In this example we are just going to send 4 channels.
-	return 0;
+	// connected to the CHOP. We send the hits and misses of the input cache,
+	// the constraints which could not be inserted, how many frames ago the
+	// input of the shown triangulation was cooked, the sizes of the last cook,
+	// and the last, mean, 95th percentile and max time of every stage.
+	return NumCountChannels + 4 * CookTimings::NumStages;
 }
 
 void
 DelaunayTriangulationSop::getInfoCHOPChan(int32_t index,
 								OP_InfoCHOPChan* chan, void* reserved)
 {
+	switch (index) {
+
+	case 0:
+		chan->name->setString("cache_hits");
+		chan->value = static_cast<float>(myCacheHits);
+		break;
+
+	case 1:
+		chan->name->setString("cache_misses");
+		chan->value = static_cast<float>(myCacheMisses);
+		break;
+
+	case 2:
+		chan->name->setString("skipped_constraints");
+		chan->value = static_cast<float>(myResultSkipped);
+		break;
+
+	case 3:
+		chan->name->setString("result_age");
+		chan->value = static_cast<float>(myResultFrame >= 0 ? myFrame - myResultFrame : 0);
+		break;
+
+	case 4:
+		chan->name->setString("input_points");
+		chan->value = static_cast<float>(myNumInputPoints);
+		break;
+
+	case 5:
+		chan->name->setString("output_points");
+		chan->value = static_cast<float>(myNumOutputPoints);
+		break;
+
+	case 6:
+		chan->name->setString("output_triangles");
+		chan->value = static_cast<float>(myNumOutputTriangles);
+		break;
+
+	case 7:
+		chan->name->setString("memory_bytes");
+		chan->value = static_cast<float>(getMemoryUsage());
+		break;
+
+	default: {
+		// four channels per stage, named like projection_p95_ms
+		static const char* const Statistics[] = { "", "_mean", "_p95", "_max" };
+		const int statistic = (index - NumCountChannels) % 4;
+		const CookTimings::Stage stage = static_cast<CookTimings::Stage>((index - NumCountChannels) / 4);
+		const CookTimings::Summary& summary = myTimings.getSummary(stage);
+		const double values[] = { summary.last, summary.mean, summary.p95, summary.max };
+
+		char name[64];
+		snprintf(name, sizeof(name), "%s%s_ms", CookTimings::getName(stage), Statistics[statistic]);
+		chan->name->setString(name);
+		chan->value = static_cast<float>(values[statistic]);
+		break;
+	}
+	}
 }
 
 bool
 DelaunayTriangulationSop::getInfoDATSize(OP_InfoDATSize* infoSize, void* reserved)
 {
-	return false;
+	// a header, then the last cooks from the most recent
+	infoSize->rows = 1 + myHistory.getNumRecords();
+	infoSize->cols = NumHistoryColumns;
+	infoSize->byColumn = false;
+	return true;
 }
 
 void
@@ -292,10 +1219,62 @@ DelaunayTriangulationSop::getInfoDATEntries(int32_t index,
 								OP_InfoDATEntries* entries,
 								void* reserved)
 {
+	if (index == 0) {
+		static const char* const Names[] = { "frame", "input_points", "triangles", "hull_size", "duplicates", "cache" };
+		for (int32_t i = 0; i < nEntries && i < NumHistoryColumns; i++) {
+			char name[64];
+			if (i < 6) {
+				snprintf(name, sizeof(name), "%s", Names[i]);
+			} else if (i < 6 + CookTimings::NumStages) {
+				snprintf(name, sizeof(name), "%s_ms", CookTimings::getName(static_cast<CookTimings::Stage>(i - 6)));
+			} else {
+				snprintf(name, sizeof(name), "peak_memory");
+			}
+			entries->values[i]->setString(name);
+		}
+		return;
+	}
+
+	CookHistory::Record record;
+	if (!myHistory.read(index - 1, record)) {
+		return;
+	}
+	static const char* const CacheNames[] = { "miss", "hit", "none" };
+	for (int32_t i = 0; i < nEntries && i < NumHistoryColumns; i++) {
+		char value[64];
+		switch (i) {
+		case 0: snprintf(value, sizeof(value), "%lld", static_cast<long long>(record.frame)); break;
+		case 1: snprintf(value, sizeof(value), "%u", record.inputPoints); break;
+		case 2: snprintf(value, sizeof(value), "%u", record.outputTriangles); break;
+		case 3: snprintf(value, sizeof(value), "%u", record.hullSize); break;
+		case 4: snprintf(value, sizeof(value), "%u", record.duplicates); break;
+		case 5: snprintf(value, sizeof(value), "%s", CacheNames[static_cast<int>(record.cache)]); break;
+		default:
+			if (i < 6 + CookTimings::NumStages) {
+				snprintf(value, sizeof(value), "%.3f", record.stageMs[i - 6]);
+			} else {
+				snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(record.peakMemory));
+			}
+			break;
+		}
+		entries->values[i]->setString(value);
+	}
 }
 
 
 
+void
+DelaunayTriangulationSop::getWarningString(OP_String* warning, void* reserved)
+{
+	if (!myWarning.empty()) {
+		warning->setString(myWarning.c_str());
+	} else if (!myCaptureWarning.empty()) {
+		warning->setString(myCaptureWarning.c_str());
+	} else if (!myTraceWarning.empty()) {
+		warning->setString(myTraceWarning.c_str());
+	}
+}
+
 void
 DelaunayTriangulationSop::setupParameters(OP_ParameterManager* manager, void* reserved)
 {
@@ -308,10 +1287,33 @@ DelaunayTriangulationSop::setupParameters(OP_ParameterManager* manager, void* re
 
 		sp.defaultValue = "XY";
 
-		const char* names[] = { "XY", "YZ", "ZX" };
-		const char* labels[] = { "XY Plane", "YZ Plane", "ZX Plane" };
+		const char* names[] = { "XY", "YZ", "ZX", "Custom", "Bestfit" };
+		const char* labels[] = { "XY Plane", "YZ Plane", "ZX Plane", "Custom Plane", "Best Fit Plane" };
 
-		OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+		OP_ParAppendResult res = manager->appendMenu(sp, 5, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// plane origin
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Planeorigin";
+		np.label = "Plane Origin";
+
+		OP_ParAppendResult res = manager->appendXYZ(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// plane normal
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Planenormal";
+		np.label = "Plane Normal";
+		np.defaultValues[2] = 1.0;
+
+		OP_ParAppendResult res = manager->appendXYZ(np);
 		assert(res == OP_ParAppendResult::Success);
 	}
 
@@ -324,16 +1326,302 @@ DelaunayTriangulationSop::setupParameters(OP_ParameterManager* manager, void* re
 
 		sp.defaultValue = "Center";
 
-		const char* names[] = { "Min", "Center", "Max", "Zero" };
-		const char* labels[] = { "Min", "Center", "Max", "Zero" };
+		const char* names[] = { "Min", "Center", "Max", "Zero", "Original" };
+		const char* labels[] = { "Min", "Center", "Max", "Zero", "Keep Original Coordinate" };
+
+		OP_ParAppendResult res = manager->appendMenu(sp, 5, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// engine
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Engine";
+		sp.label = "Engine";
+
+		sp.defaultValue = "Sweephull";
+
+		const char* names[] = { "Sweephull", "Divideandconquer" };
+		const char* labels[] = { "Sweep Hull", "Parallel Divide and Conquer" };
+
+		OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// triangulate per
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Triangulateper";
+		sp.label = "Triangulate Per";
+
+		sp.defaultValue = "All";
+
+		const char* names[] = { "All", "Primitive", "Attribute" };
+		const char* labels[] = { "All Points", "Primitive", "Attribute Value" };
+
+		OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// partition attribute
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Partitionattribute";
+		sp.label = "Partition Attribute";
+
+		sp.defaultValue = "id";
+
+		OP_ParAppendResult res = manager->appendString(sp);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// constrained
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Constrained";
+		np.label = "Constrain to Polygons";
+		np.defaultValues[0] = 0.0;
+
+		OP_ParAppendResult res = manager->appendToggle(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// output mode
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Outputmode";
+		sp.label = "Output Mode";
+
+		sp.defaultValue = "Triangles";
+
+		const char* names[] = { "Triangles", "Voronoi", "Hull", "Boundary" };
+		const char* labels[] = { "Delaunay Triangles", "Voronoi Edges", "Convex Hull", "Boundary Loops" };
 
 		OP_ParAppendResult res = manager->appendMenu(sp, 4, names, labels);
 		assert(res == OP_ParAppendResult::Success);
 	}
+
+	// voronoi padding
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Voronoipadding";
+		np.label = "Voronoi Padding";
+		np.defaultValues[0] = 0.0;
+		np.minSliders[0] = 0.0;
+		np.maxSliders[0] = 10.0;
+
+		OP_ParAppendResult res = manager->appendFloat(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// cull mode
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Cullmode";
+		sp.label = "Cull Triangles";
+
+		sp.defaultValue = "None";
+
+		const char* names[] = { "None", "Edgelength", "Circumradius" };
+		const char* labels[] = { "None", "Max Edge Length", "Max Circumradius (Alpha Shape)" };
+
+		OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// cull threshold
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Cullthreshold";
+		np.label = "Cull Threshold";
+		np.defaultValues[0] = 1.0;
+		np.minSliders[0] = 0.0;
+		np.maxSliders[0] = 10.0;
+		np.minValues[0] = 0.0;
+		np.clampMins[0] = true;
+
+		OP_ParAppendResult res = manager->appendFloat(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// mask mode
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Maskmode";
+		sp.label = "Mask Mode";
+
+		sp.defaultValue = "Clip";
+
+		const char* names[] = { "Clip", "Holes" };
+		const char* labels[] = { "Keep Inside", "Remove Inside" };
+
+		OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// max retained memory
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Maxretainedmemory";
+		np.label = "Max Retained Memory (MB)";
+		np.defaultValues[0] = 2048;
+		np.minSliders[0] = 0;
+		np.maxSliders[0] = 8192;
+		np.minValues[0] = 0;
+		np.clampMins[0] = true;
+
+		OP_ParAppendResult res = manager->appendInt(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// background
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Background";
+		np.label = "Triangulate in Background";
+		np.defaultValues[0] = 0.0;
+
+		OP_ParAppendResult res = manager->appendToggle(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// cook budget
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Cookbudget";
+		np.label = "Cook Budget (ms)";
+		np.defaultValues[0] = 0.0;
+		np.minSliders[0] = 0.0;
+		np.maxSliders[0] = 50.0;
+		np.minValues[0] = 0.0;
+		np.clampMins[0] = true;
+
+		OP_ParAppendResult res = manager->appendFloat(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// max threads
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Maxthreads";
+		np.label = "Max Threads";
+		np.defaultValues[0] = 0;
+		np.minSliders[0] = 0;
+		np.maxSliders[0] = 64;
+		np.minValues[0] = 0;
+		np.clampMins[0] = true;
+
+		OP_ParAppendResult res = manager->appendInt(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// shared points
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Sharedpoints";
+		np.label = "Shared Points";
+		np.defaultValues[0] = 0.0;
+
+		OP_ParAppendResult res = manager->appendToggle(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// direct to gpu
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Directtogpu";
+		np.label = "Direct to GPU";
+		np.defaultValues[0] = 0.0;
+
+		OP_ParAppendResult res = manager->appendToggle(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// capture file
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Capturefile";
+		sp.label = "Capture File";
+		sp.defaultValue = "";
+
+		OP_ParAppendResult res = manager->appendFile(sp);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// capture cooks
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Capturecooks";
+		np.label = "Capture Cooks";
+		np.defaultValues[0] = 60;
+		np.minSliders[0] = 1;
+		np.maxSliders[0] = 600;
+		np.minValues[0] = 1;
+		np.clampMins[0] = true;
+
+		OP_ParAppendResult res = manager->appendInt(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// capture
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Capture";
+		np.label = "Capture";
+
+		OP_ParAppendResult res = manager->appendPulse(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// trace file
+	{
+		OP_StringParameter	sp;
+
+		sp.name = "Tracefile";
+		sp.label = "Trace File";
+		sp.defaultValue = "";
+
+		OP_ParAppendResult res = manager->appendFile(sp);
+		assert(res == OP_ParAppendResult::Success);
+	}
+
+	// trace
+	{
+		OP_NumericParameter	np;
+
+		np.name = "Trace";
+		np.label = "Trace";
+		np.defaultValues[0] = 0.0;
+
+		OP_ParAppendResult res = manager->appendToggle(np);
+		assert(res == OP_ParAppendResult::Success);
+	}
 }
 
 void
 DelaunayTriangulationSop::pulsePressed(const char* name, void* reserved)
 {
+	// the file is created by the next cook, which has the parameters
+	if (strcmp(name, "Capture") == 0) {
+		myCaptureRequested = true;
+	}
 }
 
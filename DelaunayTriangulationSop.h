@@ -15,7 +15,25 @@
 #pragma once
 
 #include "SOP_CPlusPlusBase.h"
+#include "BackgroundTriangulation.h"
+#include "BoundaryLoops.h"
+#include "ConstrainedDelaunay.h"
+#include "ConvexHull.h"
+#include "CookCapture.h"
+#include "CookHistory.h"
+#include "CookTimings.h"
+#include "CookTrace.h"
+#include "DivideAndConquerDelaunay.h"
+#include "PartitionedDelaunay.h"
+#include "PolygonMask.h"
+#include "Projection.h"
+#include "SweepHullDelaunay.h"
+#include "ThreadPool.h"
+#include "TriangleCulling.h"
+#include "Triangulation.h"
+#include "Voronoi.h"
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -47,6 +65,8 @@ public:
 									OP_InfoDATEntries* entries,
 									void* reserved) override;
 
+	virtual void getWarningString(OP_String* warning, void* reserved) override;
+
 	virtual void setupParameters(OP_ParameterManager* manager, void* reserved) override;
 	virtual void pulsePressed(const char* name, void* reserved) override;
 
@@ -59,10 +79,218 @@ private:
 	const OP_NodeInfo*		myNodeInfo;
 
 
-	enum Axis { x, y, z};
-	enum LimitMode {min, center, max, zero};
+	// custom and bestFit project on myPlane, its normal is the limited axis
+	enum Axis { x, y, z, custom, bestFit };
+	// original keeps the input positions, the points are only projected to be triangulated
+	enum LimitMode {min, center, max, zero, original};
+	enum Engine {sweepHull, divideAndConquer};
+	enum OutputMode {triangles, voronoi, hull, boundary};
+	// the points are split by primitive or by the value of an attribute, and every part is triangulated alone
+	enum PartitionMode {all, primitive, attribute};
+
+	Axis getLimitedAxis(const OP_Inputs* inputs);
+
+	ProjectionPlane getCustomPlane(const OP_Inputs* inputs);
+
+	LimitMode getLimitMode(const OP_Inputs* inputs);
+
+	Engine getEngine(const OP_Inputs* inputs);
+
+	OutputMode getOutputMode(const OP_Inputs* inputs);
+
+	PartitionMode getPartitionMode(const OP_Inputs* inputs);
+
+	TriangleCulling::Mode getCullMode(const OP_Inputs* inputs);
+
+	// reads the settings shared by every stage of the cook, and records the cook when capturing
+	void beginCook(const OP_Inputs* inputs);
+
+	// adds the timings and sizes of the cook to their statistics and to the history
+	void endCook();
+
+	float getLimitedValue(Axis limitedAxis, LimitMode mode);
+
+	// bounds of the output points
+	BoundingBox getOutputBounds(Axis limitedAxis, LimitMode mode, float limitedValue);
+
+	Position build3dPosition(float u, float v, Axis limitedAxis, float limitedValue);
+
+	// the 3d positions of all the projected points, in parallel
+	void build3dPositions(Position* positions, Axis limitedAxis, float limitedValue);
+
+	void triangulate(const std::vector<float>& coords, Engine engine, Triangulation& triangulation);
+
+	// hash of the input points and of the settings of the projection
+	uint64_t hashInput(const Position* positions, size_t numPoints, Axis limitedAxis, const ProjectionPlane& customPlane);
+
+	// the 2d points to triangulate and the stats of the limited axis, in the same pass
+	void projectInput(const Position* positions, size_t numPoints, Axis limitedAxis, const ProjectionPlane& customPlane,
+					  std::vector<float>& coords, ProjectionPlane& plane, ProjectionStats& stats);
+
+	// fills edges with two point indices per edge of the polygons of sinput,
+	// the polygons of two points are single edges unless closedOnly is set
+	void gatherEdges(const OP_SOPInput* sinput, bool closedOnly, std::vector<int32_t>& edges);
+
+	// fills myPartitions with the partition of every point
+	void gatherPartitions(const OP_SOPInput* sinput, PartitionMode partitionMode, const char* attributeName);
+
+	// the hull doesn't need the triangles, then only the 2d points are updated.
+	// When constrained, the edges of the input polygons are forced into the triangulation
+	// and the triangles outside of them are removed.
+	// In the background, or when the triangulation has a budget of milliseconds per cook,
+	// the result of the last job is used until the next one is done.
+	float updateTriangulation(const OP_SOPInput* sinput, Axis limitedAxis, LimitMode limitMode, Engine engine,
+							  const ProjectionPlane& customPlane, bool constrained,
+							  PartitionMode partitionMode, const char* partitionAttribute, bool needTriangles,
+							  bool background, double budget);
+
+	// takes the result of myBackground when it is done, and starts the next job
+	// when the input changed and it is idle. Unless threaded, the job is carried on
+	// by every cook for budget milliseconds.
+	float updateBackgroundTriangulation(const OP_SOPInput* sinput, Axis limitedAxis, LimitMode limitMode, Engine engine,
+										const ProjectionPlane& customPlane, bool constrained,
+										PartitionMode partitionMode, const char* partitionAttribute,
+										bool needTriangles, bool threaded, double budget);
+
+	// the result of the finished job of myBackground becomes myCoords and myTriangulation,
+	// unless the shown result is newer
+	void acceptBackgroundResult();
+
+	// the position of the input points the last 2d points were projected from
+	const Position* getInputPositions(const OP_SOPInput* sinput);
+
+	// projects the polygons of the second input on the plane of the triangulation,
+	// the grid of myMask is only rebuilt when they changed. False without a second input.
+	bool updateMask(const OP_Inputs* inputs, Axis limitedAxis);
+
+	// the triangles left once the mask and the culling parameters removed some
+	const std::vector<std::size_t>& cullTriangles(const OP_Inputs* inputs, Axis limitedAxis);
+
+	// emit the voronoi diagram of the last triangulation instead of its triangles
+	void outputVoronoi(SOP_Output* output, const OP_Inputs* inputs, Axis limitedAxis, LimitMode limitMode, float limitedValue);
+
+	// emit the convex hull of the last 2d points as one closed line
+	void outputHull(SOP_Output* output, const Position* inputPositions, Axis limitedAxis, LimitMode limitMode, float limitedValue);
+
+	// emit the outlines of the triangles left by the culling, one closed line per loop
+	void outputBoundary(SOP_Output* output, const OP_Inputs* inputs, const Position* inputPositions, Axis limitedAxis, LimitMode limitMode, float limitedValue);
+
+	// bytes held by the buffers kept between cooks
+	size_t getMemoryUsage() const;
+
+	// bytes of those held by the shown result and the mask, which are never trimmed
+	size_t getResultMemoryUsage() const;
+
+	// give the work buffers back when they grew over the Max Retained Memory parameter.
+	// The shown result is the cache of the input, freeing it would redo it every cook.
+	void trimMemory(const OP_Inputs* inputs);
+
+	// the workers of the process, capped by the max threads parameter of this node
+	ThreadPool					myThreadPool;
+
+	// the absolute frame of the current cook
+	int64_t						myFrame;
+
+	// where the time of the cooks goes, and what the last cook took in and put out
+	CookTimings					myTimings;
+	int32_t						myNumInputPoints;
+	int32_t						myNumOutputPoints;
+	int32_t						myNumOutputTriangles;
+	CookHistory					myHistory;
+
+	// while the Trace toggle is on, the spans of the cooks go to the file of myTracePath.
+	// It outlives myBackground, whose jobs trace to it.
+	CookTrace					myTrace;
+	std::string					myTracePath;
+	std::string					myTraceWarning;
+
+	// the cache counts when the cook started, and the bytes held before trimming
+	int64_t						myCookCacheHits;
+	int64_t						myCookCacheMisses;
+	size_t						myCookMemory;
+
+	SweepHullDelaunay			mySweepHull;
+	DivideAndConquerDelaunay	myDivideAndConquer;
+	ConstrainedDelaunay			myConstrained;
+	PartitionedDelaunay			myPartitioned;
+	VoronoiDiagram				myVoronoi;
+	ConvexHull					myConvexHull;
+	TriangleCulling				myCulling;
+	PolygonMask					myMask;
+	BoundaryLoops				myBoundary;
+
+	// the last 2d points, and their triangulation when myHasTriangulation is set
+	std::vector<float>			myCoords;
+	std::vector<float>			myNewCoords;
+	bool						myHasCoords;
+	Triangulation				myTriangulation;
+	Engine						myTriangulationEngine;
+	bool						myHasTriangulation;
+	TriangulationCounts			myTriangulationCounts;
+	std::vector<uint8_t>		myUsedPoints;
+
+	// two point indices per edge of the input polygons, and their hash when the
+	// triangulation was constrained to them, 0 otherwise
+	std::vector<int32_t>		myConstraintEdges;
+	uint64_t					myConstraintHash;
+
+	// the partition of every point and their hash when the triangulation was partitioned, 0 otherwise
+	std::vector<uint32_t>		myPartitions;
+	uint32_t					myNumPartitions;
+	uint64_t					myPartitionHash;
+	std::unordered_map<int32_t, uint32_t>	myPartitionOfValue;
+
+	// hash of the input points and settings of the last triangulation
+	uint64_t					myInputHash;
+	ProjectionStats				myInputStats;
+	ProjectionPlane				myPlane;
+
+	int64_t						myCacheHits;
+	int64_t						myCacheMisses;
+
+	// in the background or sliced, myCoords and myTriangulation are the result of a job and
+	// myResultFrame the last frame whose input they match, -1 when they don't come from a job
+	BackgroundTriangulation		myBackground;
+	int64_t						myResultFrame;
+	uint64_t					myResultHash;
+	std::vector<Position>		myResultPositions;
+
+	// the constraints left out of the shown triangulation, by a job or the cook
+	size_t						myResultSkipped;
+
+	// what the running job was started with, handed over with its result
+	struct BackgroundInput
+	{
+		uint64_t				hash;
+		uint64_t				inputHash;
+		uint64_t				constraintHash;
+		uint64_t				partitionHash;
+		Engine					engine;
+		ProjectionStats			stats;
+		ProjectionPlane			plane;
+		int64_t					frame;
+		std::vector<Position>	positions;
+	};
+	BackgroundInput				myBackgroundInput;
+
+	// the node has to cook again for the background to catch up with the input
+	bool						myBackgroundPending;
+
+	std::string					myWarning;
+
+	// the Capture pulse starts recording at the next cook
+	CookCapture					myCapture;
+	bool						myCaptureRequested;
+	std::string					myCaptureWarning;
 
-	float getLimitedValue(const Position* ptArr, size_t numPoints, Axis limitedAxis, LimitMode mode);
+	// the polygons of the second input, myMask is valid for myMaskHash when myHasMask is set
+	std::vector<float>			myMaskCoords;
+	std::vector<int32_t>		myMaskEdges;
+	uint64_t					myMaskHash;
+	bool						myHasMask;
 
-	void build2dCoordsVector(std::vector<double>& coords, const Position* ptArr, size_t numPoints, Axis limitedAxis);
+	// staging for the shared points output
+	std::vector<Position>		myOutputPositions;
+	std::vector<int32_t>		myOutputIndices;
+	std::vector<int32_t>		myOutputLineSizes;
 };
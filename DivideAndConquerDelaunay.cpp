@@ -0,0 +1,402 @@
+#include "DivideAndConquerDelaunay.h"
+#include "Predicates.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+	const uint32_t InvalidPoint = 0xFFFFFFFF;
+
+	// below this many points per strip the threads cost more than they save
+	const std::size_t MinStripSize = 1 << 14;
+}
+
+bool
+DivideAndConquerDelaunay::ccw(uint32_t a, uint32_t b, uint32_t c) const
+{
+	const SortedPoint& pa = myPoints[a];
+	const SortedPoint& pb = myPoints[b];
+	const SortedPoint& pc = myPoints[c];
+	return Predicates::orient2d(pa.x, pa.y, pb.x, pb.y, pc.x, pc.y) > 0.0;
+}
+
+bool
+DivideAndConquerDelaunay::inCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t d) const
+{
+	// true when d is inside the circle going through the counter clockwise triangle a, b, c
+	const SortedPoint& pa = myPoints[a];
+	const SortedPoint& pb = myPoints[b];
+	const SortedPoint& pc = myPoints[c];
+	const SortedPoint& pd = myPoints[d];
+	return Predicates::inCircle(pa.x, pa.y, pb.x, pb.y, pc.x, pc.y, pd.x, pd.y) > 0.0;
+}
+
+DivideAndConquerDelaunay::Edge
+DivideAndConquerDelaunay::makeEdge(uint32_t orgPoint, uint32_t destPoint, Arena& arena)
+{
+	uint32_t quad;
+	if (arena.freeHead != InvalidPoint) {
+		quad = arena.freeHead;
+		arena.freeHead = myNext[4 * quad];
+		if (arena.freeHead == InvalidPoint) {
+			arena.freeTail = InvalidPoint;
+		}
+	} else {
+		assert(arena.bump < arena.end);
+		quad = arena.bump++;
+	}
+
+	Edge e = 4 * quad;
+	myNext[e] = e;
+	myNext[e + 1] = e + 3;
+	myNext[e + 2] = e + 2;
+	myNext[e + 3] = e + 1;
+	myOrigin[2 * quad] = orgPoint;
+	myOrigin[2 * quad + 1] = destPoint;
+	return e;
+}
+
+void
+DivideAndConquerDelaunay::splice(Edge a, Edge b)
+{
+	Edge alpha = rot(myNext[a]);
+	Edge beta = rot(myNext[b]);
+	std::swap(myNext[a], myNext[b]);
+	std::swap(myNext[alpha], myNext[beta]);
+}
+
+DivideAndConquerDelaunay::Edge
+DivideAndConquerDelaunay::connect(Edge a, Edge b, Arena& arena)
+{
+	Edge e = makeEdge(dest(a), org(b), arena);
+	splice(e, lnext(a));
+	splice(sym(e), b);
+	return e;
+}
+
+void
+DivideAndConquerDelaunay::deleteEdge(Edge e, Arena& arena)
+{
+	splice(e, oprev(e));
+	splice(sym(e), oprev(sym(e)));
+
+	uint32_t quad = e >> 2;
+	myOrigin[2 * quad] = InvalidPoint;
+	myOrigin[2 * quad + 1] = InvalidPoint;
+
+	myNext[4 * quad] = arena.freeHead;
+	arena.freeHead = quad;
+	if (arena.freeTail == InvalidPoint) {
+		arena.freeTail = quad;
+	}
+}
+
+void
+DivideAndConquerDelaunay::sortPoints(const std::vector<float>& coords, ThreadPool& pool)
+{
+	const std::size_t numPoints = coords.size() / 2;
+	myPoints.resize(numPoints);
+	mySortBuffer.resize(numPoints);
+
+	auto less = [](const SortedPoint& a, const SortedPoint& b) {
+		return a.x < b.x || (a.x == b.x && a.y < b.y);
+	};
+
+	// sort one chunk per thread, then merge the chunks two by two
+	std::size_t numChunks = 1;
+	while (numChunks < pool.getNumThreads() && numPoints / (numChunks * 2) >= MinStripSize) {
+		numChunks *= 2;
+	}
+	std::vector<std::size_t> bounds(numChunks + 1);
+	for (std::size_t i = 0; i <= numChunks; i++) {
+		bounds[i] = numPoints * i / numChunks;
+	}
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		for (std::size_t i = bounds[chunk]; i < bounds[chunk + 1]; i++) {
+			myPoints[i].x = coords[2 * i];
+			myPoints[i].y = coords[2 * i + 1];
+			myPoints[i].index = static_cast<uint32_t>(i);
+		}
+		std::sort(myPoints.begin() + bounds[chunk], myPoints.begin() + bounds[chunk + 1], less);
+	});
+
+	for (std::size_t step = 1; step < numChunks; step *= 2) {
+		pool.parallelFor(numChunks / (2 * step), [&](std::size_t pair) {
+			std::size_t begin = bounds[2 * step * pair];
+			std::size_t middle = bounds[2 * step * pair + step];
+			std::size_t end = bounds[2 * step * (pair + 1)];
+			std::merge(myPoints.begin() + begin, myPoints.begin() + middle,
+					   myPoints.begin() + middle, myPoints.begin() + end,
+					   mySortBuffer.begin() + begin, less);
+		});
+		myPoints.swap(mySortBuffer);
+	}
+
+	// the algorithm needs distinct points, the duplicates are left out of the triangulation
+	auto last = std::unique(myPoints.begin(), myPoints.end(), [](const SortedPoint& a, const SortedPoint& b) {
+		return a.x == b.x && a.y == b.y;
+	});
+	myPoints.erase(last, myPoints.end());
+}
+
+std::pair<DivideAndConquerDelaunay::Edge, DivideAndConquerDelaunay::Edge>
+DivideAndConquerDelaunay::triangulateRange(uint32_t begin, uint32_t end, Arena& arena)
+{
+	uint32_t numPoints = end - begin;
+
+	if (numPoints == 2) {
+		Edge a = makeEdge(begin, begin + 1, arena);
+		return std::make_pair(a, sym(a));
+	}
+
+	if (numPoints == 3) {
+		uint32_t p0 = begin;
+		uint32_t p1 = begin + 1;
+		uint32_t p2 = begin + 2;
+
+		Edge a = makeEdge(p0, p1, arena);
+		Edge b = makeEdge(p1, p2, arena);
+		splice(sym(a), b);
+
+		if (ccw(p0, p1, p2)) {
+			connect(b, a, arena);
+			return std::make_pair(a, sym(b));
+		} else if (ccw(p0, p2, p1)) {
+			Edge c = connect(b, a, arena);
+			return std::make_pair(sym(c), c);
+		}
+
+		// the three points are aligned
+		return std::make_pair(a, sym(b));
+	}
+
+	uint32_t middle = begin + numPoints / 2;
+	std::pair<Edge, Edge> left = triangulateRange(begin, middle, arena);
+	std::pair<Edge, Edge> right = triangulateRange(middle, end, arena);
+	return merge(left.first, left.second, right.first, right.second, arena);
+}
+
+std::pair<DivideAndConquerDelaunay::Edge, DivideAndConquerDelaunay::Edge>
+DivideAndConquerDelaunay::merge(Edge ldo, Edge ldi, Edge rdi, Edge rdo, Arena& arena)
+{
+	// find the lower common tangent of the two hulls
+	while (true) {
+		if (leftOf(org(rdi), ldi)) {
+			ldi = lnext(ldi);
+		} else if (rightOf(org(ldi), rdi)) {
+			rdi = rprev(rdi);
+		} else {
+			break;
+		}
+	}
+
+	Edge basel = connect(sym(rdi), ldi, arena);
+	if (org(ldi) == org(ldo)) {
+		ldo = sym(basel);
+	}
+	if (org(rdi) == org(rdo)) {
+		rdo = basel;
+	}
+
+	// zip the seam upward, removing the edges that are not delaunay anymore
+	while (true) {
+		Edge lcand = onext(sym(basel));
+		bool lvalid = rightOf(dest(lcand), basel);
+		if (lvalid) {
+			while (inCircle(dest(basel), org(basel), dest(lcand), dest(onext(lcand)))) {
+				Edge next = onext(lcand);
+				deleteEdge(lcand, arena);
+				lcand = next;
+			}
+		}
+
+		Edge rcand = oprev(basel);
+		bool rvalid = rightOf(dest(rcand), basel);
+		if (rvalid) {
+			while (inCircle(dest(basel), org(basel), dest(rcand), dest(oprev(rcand)))) {
+				Edge next = oprev(rcand);
+				deleteEdge(rcand, arena);
+				rcand = next;
+			}
+		}
+
+		if (!lvalid && !rvalid) {
+			break;
+		}
+
+		if (!lvalid || (rvalid && inCircle(dest(lcand), org(lcand), org(rcand), dest(rcand)))) {
+			basel = connect(rcand, sym(basel), arena);
+		} else {
+			basel = connect(sym(basel), sym(lcand), arena);
+		}
+	}
+
+	return std::make_pair(ldo, rdo);
+}
+
+void
+DivideAndConquerDelaunay::buildTriangulation(ThreadPool& pool, Triangulation& result)
+{
+	const std::size_t numDirections = myOrigin.size();
+
+	// a triangle is found from the smallest of its three counter clockwise edges
+	auto findTriangle = [this](std::size_t direction, Edge& e0, Edge& e1, Edge& e2) {
+		if (myOrigin[direction] == InvalidPoint) {
+			return false;
+		}
+		e0 = static_cast<Edge>(2 * direction);
+		e1 = lnext(e0);
+		e2 = lnext(e1);
+		return lnext(e2) == e0 && e0 < e1 && e0 < e2 && ccw(org(e0), org(e1), org(e2));
+	};
+
+	std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numDirections / MinStripSize));
+	std::vector<std::size_t> offsets(numChunks + 1, 0);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		Edge e0, e1, e2;
+		std::size_t count = 0;
+		for (std::size_t d = numDirections * chunk / numChunks; d < numDirections * (chunk + 1) / numChunks; d++) {
+			if (findTriangle(d, e0, e1, e2)) {
+				count++;
+			}
+		}
+		offsets[chunk + 1] = count;
+	});
+	for (std::size_t i = 0; i < numChunks; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	const std::size_t numTriangles = offsets[numChunks];
+	result.triangles.resize(3 * numTriangles);
+	result.halfedges.resize(3 * numTriangles);
+	myHalfedgeOfEdge.assign(numDirections, Triangulation::InvalidIndex);
+
+	// write the triangles clockwise like delaunator does, so the halfedges
+	// of a triangle are the reverse of the counter clockwise quad-edges
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		Edge e0, e1, e2;
+		std::size_t t = offsets[chunk];
+		for (std::size_t d = numDirections * chunk / numChunks; d < numDirections * (chunk + 1) / numChunks; d++) {
+			if (!findTriangle(d, e0, e1, e2)) {
+				continue;
+			}
+			result.triangles[3 * t] = myPoints[org(e0)].index;
+			result.triangles[3 * t + 1] = myPoints[org(e2)].index;
+			result.triangles[3 * t + 2] = myPoints[org(e1)].index;
+			myHalfedgeOfEdge[sym(e2) >> 1] = 3 * t;
+			myHalfedgeOfEdge[sym(e1) >> 1] = 3 * t + 1;
+			myHalfedgeOfEdge[sym(e0) >> 1] = 3 * t + 2;
+			t++;
+		}
+	});
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		Edge e0, e1, e2;
+		std::size_t t = offsets[chunk];
+		for (std::size_t d = numDirections * chunk / numChunks; d < numDirections * (chunk + 1) / numChunks; d++) {
+			if (!findTriangle(d, e0, e1, e2)) {
+				continue;
+			}
+			result.halfedges[3 * t] = myHalfedgeOfEdge[e2 >> 1];
+			result.halfedges[3 * t + 1] = myHalfedgeOfEdge[e1 >> 1];
+			result.halfedges[3 * t + 2] = myHalfedgeOfEdge[e0 >> 1];
+			t++;
+		}
+	});
+}
+
+std::size_t
+DivideAndConquerDelaunay::getMemoryUsage() const
+{
+	return myPoints.capacity() * sizeof(SortedPoint) +
+		mySortBuffer.capacity() * sizeof(SortedPoint) +
+		myNext.capacity() * sizeof(Edge) +
+		myOrigin.capacity() * sizeof(uint32_t) +
+		myHalfedgeOfEdge.capacity() * sizeof(std::size_t);
+}
+
+void
+DivideAndConquerDelaunay::releaseMemory()
+{
+	std::vector<SortedPoint>().swap(myPoints);
+	std::vector<SortedPoint>().swap(mySortBuffer);
+	std::vector<Edge>().swap(myNext);
+	std::vector<uint32_t>().swap(myOrigin);
+	std::vector<std::size_t>().swap(myHalfedgeOfEdge);
+}
+
+void
+DivideAndConquerDelaunay::triangulate(const std::vector<float>& coords, ThreadPool& pool, Triangulation& result)
+{
+	result.triangles.clear();
+	result.halfedges.clear();
+
+	sortPoints(coords, pool);
+
+	const uint32_t numPoints = static_cast<uint32_t>(myPoints.size());
+	if (numPoints < 2) {
+		return;
+	}
+
+	// a planar graph of n points never has more than 3n edges alive
+	const std::size_t numQuads = 3 * static_cast<std::size_t>(numPoints);
+	myNext.resize(4 * numQuads);
+	myOrigin.assign(2 * numQuads, InvalidPoint);
+
+	std::size_t numStrips = 1;
+	while (numStrips < pool.getNumThreads() && numPoints / (numStrips * 2) >= MinStripSize) {
+		numStrips *= 2;
+	}
+
+	std::vector<Arena> arenas(numStrips);
+	std::vector<std::pair<Edge, Edge>> hulls(numStrips);
+
+	pool.parallelFor(numStrips, [&](std::size_t strip) {
+		uint32_t begin = static_cast<uint32_t>(numPoints * strip / numStrips);
+		uint32_t end = static_cast<uint32_t>(numPoints * (strip + 1) / numStrips);
+
+		Arena& arena = arenas[strip];
+		arena.freeHead = InvalidPoint;
+		arena.freeTail = InvalidPoint;
+		arena.bump = 3 * begin;
+		arena.end = 3 * end;
+
+		hulls[strip] = triangulateRange(begin, end, arena);
+
+		// hand the quads left over to the free list, so the merges can use them
+		for (; arena.bump < arena.end; arena.bump++) {
+			myNext[4 * arena.bump] = arena.freeHead;
+			arena.freeHead = arena.bump;
+			if (arena.freeTail == InvalidPoint) {
+				arena.freeTail = arena.bump;
+			}
+		}
+	});
+
+	// stitch the seams between neighbour strips
+	for (std::size_t step = 1; step < numStrips; step *= 2) {
+		pool.parallelFor(numStrips / (2 * step), [&](std::size_t pair) {
+			std::size_t left = 2 * step * pair;
+			std::size_t right = left + step;
+
+			Arena& arena = arenas[left];
+			const Arena& rightArena = arenas[right];
+			if (arena.freeHead == InvalidPoint) {
+				arena.freeHead = rightArena.freeHead;
+				arena.freeTail = rightArena.freeTail;
+			} else if (rightArena.freeHead != InvalidPoint) {
+				myNext[4 * arena.freeTail] = rightArena.freeHead;
+				arena.freeTail = rightArena.freeTail;
+			}
+
+			hulls[left] = merge(hulls[left].first, hulls[left].second,
+								hulls[right].first, hulls[right].second, arena);
+		});
+	}
+
+	buildTriangulation(pool, result);
+}
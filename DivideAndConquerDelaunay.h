@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+
+// Guibas & Stolfi divide and conquer delaunay triangulation on a quad-edge structure.
+// The points are sorted along x and cut into vertical strips that are triangulated
+// in parallel, then neighbour strips are merged two by two, one level at a time.
+class DivideAndConquerDelaunay
+{
+public:
+
+	// coords holds x0, y0, x1, y1, ... like for delaunator::Delaunator, but in single precision
+	void triangulate(const std::vector<float>& coords, ThreadPool& pool, Triangulation& result);
+
+	// bytes held by the work buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the work buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// a directed edge is the quad-edge index times 4 plus its rotation
+	typedef uint32_t Edge;
+
+	// quads available to one strip, the free list is chained through myNext
+	struct Arena
+	{
+		uint32_t	freeHead;
+		uint32_t	freeTail;
+		uint32_t	bump;
+		uint32_t	end;
+	};
+
+	struct SortedPoint
+	{
+		float		x;
+		float		y;
+		uint32_t	index;
+	};
+
+	void sortPoints(const std::vector<float>& coords, ThreadPool& pool);
+
+	std::pair<Edge, Edge> triangulateRange(uint32_t begin, uint32_t end, Arena& arena);
+
+	std::pair<Edge, Edge> merge(Edge ldo, Edge ldi, Edge rdi, Edge rdo, Arena& arena);
+
+	void buildTriangulation(ThreadPool& pool, Triangulation& result);
+
+	Edge makeEdge(uint32_t org, uint32_t dest, Arena& arena);
+	Edge connect(Edge a, Edge b, Arena& arena);
+	void deleteEdge(Edge e, Arena& arena);
+	void splice(Edge a, Edge b);
+
+	static Edge rot(Edge e) { return (e & ~3u) | ((e + 1) & 3u); }
+	static Edge sym(Edge e) { return e ^ 2u; }
+	static Edge rotInv(Edge e) { return (e & ~3u) | ((e + 3) & 3u); }
+
+	Edge onext(Edge e) const { return myNext[e]; }
+	Edge oprev(Edge e) const { return rot(myNext[rot(e)]); }
+	Edge lnext(Edge e) const { return rot(myNext[rotInv(e)]); }
+	Edge rprev(Edge e) const { return myNext[sym(e)]; }
+
+	uint32_t org(Edge e) const { return myOrigin[e >> 1]; }
+	uint32_t dest(Edge e) const { return myOrigin[sym(e) >> 1]; }
+
+	bool ccw(uint32_t a, uint32_t b, uint32_t c) const;
+	bool inCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t d) const;
+	bool rightOf(uint32_t p, Edge e) const { return ccw(p, dest(e), org(e)); }
+	bool leftOf(uint32_t p, Edge e) const { return ccw(p, org(e), dest(e)); }
+
+	std::vector<SortedPoint>	myPoints;
+	std::vector<SortedPoint>	mySortBuffer;
+
+	// onext of the 4 rotations of every quad-edge
+	std::vector<Edge>			myNext;
+
+	// origin of the 2 directions of every quad-edge, InvalidPoint when the quad is free
+	std::vector<uint32_t>		myOrigin;
+
+	// halfedge of the result standing for each of the 2 directions of every quad-edge
+	std::vector<std::size_t>	myHalfedgeOfEdge;
+};
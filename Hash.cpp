@@ -0,0 +1,65 @@
+#include "Hash.h"
+
+#include <string.h>
+
+namespace
+{
+	const uint32_t Prime32A = 0x9E3779B1u;
+	const uint32_t Prime32B = 0x85EBCA77u;
+	const uint64_t Prime64 = 0x9E3779B97F4A7C15ull;
+
+	const std::size_t NumLanes = 8;
+
+	inline uint32_t
+	rotl32(uint32_t x, int r)
+	{
+		return (x << r) | (x >> (32 - r));
+	}
+
+	inline uint64_t
+	mix64(uint64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xFF51AFD7ED558CCDull;
+		x ^= x >> 33;
+		x *= 0xC4CEB9FE1A85EC53ull;
+		x ^= x >> 33;
+		return x;
+	}
+}
+
+uint64_t
+hashBytes(const void* data, std::size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	uint32_t lanes[NumLanes];
+	for (std::size_t l = 0; l < NumLanes; l++) {
+		lanes[l] = static_cast<uint32_t>(seed >> (l & 1 ? 32 : 0)) + static_cast<uint32_t>(l) * Prime32A;
+	}
+
+	// the lanes don't depend on each other, so each block is one vector round
+	const std::size_t blockSize = NumLanes * sizeof(uint32_t);
+	const std::size_t numBlocks = size / blockSize;
+	for (std::size_t b = 0; b < numBlocks; b++) {
+		uint32_t words[NumLanes];
+		memcpy(words, bytes + b * blockSize, blockSize);
+		for (std::size_t l = 0; l < NumLanes; l++) {
+			lanes[l] += words[l] * Prime32B;
+			lanes[l] = rotl32(lanes[l], 13);
+			lanes[l] *= Prime32A;
+		}
+	}
+
+	uint64_t hash = mix64(seed ^ static_cast<uint64_t>(size));
+	for (std::size_t l = 0; l < NumLanes; l++) {
+		hash = (hash ^ lanes[l]) * Prime64;
+	}
+
+	// the tail which doesn't fill a whole block
+	for (std::size_t i = numBlocks * blockSize; i < size; i++) {
+		hash = (hash ^ bytes[i]) * Prime64;
+	}
+
+	return mix64(hash);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Fast 64 bit hash of a block of memory, used to find out if an input changed.
+// The bulk is hashed in 8 independent 32 bit lanes, which the compiler turns into
+// SIMD instructions. This is not a cryptographic hash.
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed);
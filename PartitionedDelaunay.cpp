@@ -0,0 +1,118 @@
+#include "PartitionedDelaunay.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+void
+PartitionedDelaunay::triangulate(const std::vector<float>& coords, const std::vector<uint32_t>& partitions, uint32_t numPartitions,
+								 bool divideAndConquer, ThreadPool& pool, Triangulation& result)
+{
+	result.triangles.clear();
+	result.halfedges.clear();
+	if (numPartitions == 0) {
+		return;
+	}
+
+	// counting sort of the points by partition
+	const std::size_t numPoints = coords.size() / 2;
+	myPointOffsets.assign(numPartitions + 1, 0);
+	for (std::size_t i = 0; i < numPoints; i++) {
+		if (partitions[i] < numPartitions) {
+			myPointOffsets[partitions[i] + 1]++;
+		}
+	}
+	for (uint32_t p = 0; p < numPartitions; p++) {
+		myPointOffsets[p + 1] += myPointOffsets[p];
+	}
+	myPoints.resize(myPointOffsets[numPartitions]);
+	for (std::size_t i = 0; i < numPoints; i++) {
+		if (partitions[i] < numPartitions) {
+			myPoints[myPointOffsets[partitions[i]]++] = static_cast<uint32_t>(i);
+		}
+	}
+	for (uint32_t p = numPartitions; p > 0; p--) {
+		myPointOffsets[p] = myPointOffsets[p - 1];
+	}
+	myPointOffsets[0] = 0;
+
+	// starting with the largest partitions keeps a big one from being left for the end
+	myOrder.resize(numPartitions);
+	for (uint32_t p = 0; p < numPartitions; p++) {
+		myOrder[p] = p;
+	}
+	std::sort(myOrder.begin(), myOrder.end(), [this](uint32_t a, uint32_t b) {
+		return myPointOffsets[a + 1] - myPointOffsets[a] > myPointOffsets[b + 1] - myPointOffsets[b];
+	});
+
+	const std::size_t numWorkers = std::min<std::size_t>(pool.getNumThreads(), numPartitions);
+	if (myWorkers.size() < numWorkers) {
+		myWorkers.resize(numWorkers);
+	}
+	myResults.resize(numPartitions);
+
+	std::atomic<uint32_t> next{ 0 };
+	pool.parallelFor(numWorkers, [&](std::size_t w) {
+		Worker& worker = myWorkers[w];
+		for (uint32_t i = next++; i < numPartitions; i = next++) {
+			const uint32_t p = myOrder[i];
+			worker.coords.resize(2 * (myPointOffsets[p + 1] - myPointOffsets[p]));
+			for (std::size_t j = myPointOffsets[p]; j < myPointOffsets[p + 1]; j++) {
+				const uint32_t point = myPoints[j];
+				worker.coords[2 * (j - myPointOffsets[p])] = coords[2 * point];
+				worker.coords[2 * (j - myPointOffsets[p]) + 1] = coords[2 * point + 1];
+			}
+
+			if (divideAndConquer) {
+				worker.divideAndConquer.triangulate(worker.coords, pool, myResults[p]);
+			} else {
+				worker.sweepHull.triangulate(worker.coords, myResults[p]);
+			}
+		}
+	});
+
+	// merge the triangulations, going back to the indices of the input points
+	myHalfedgeOffsets.assign(numPartitions + 1, 0);
+	for (uint32_t p = 0; p < numPartitions; p++) {
+		myHalfedgeOffsets[p + 1] = myHalfedgeOffsets[p] + myResults[p].triangles.size();
+	}
+	result.triangles.resize(myHalfedgeOffsets[numPartitions]);
+	result.halfedges.resize(myHalfedgeOffsets[numPartitions]);
+
+	pool.parallelFor(numPartitions, [&](std::size_t p) {
+		const Triangulation& partition = myResults[p];
+		const std::size_t offset = myHalfedgeOffsets[p];
+		const uint32_t* points = myPoints.data() + myPointOffsets[p];
+		for (std::size_t e = 0; e < partition.triangles.size(); e++) {
+			const std::size_t opposite = partition.halfedges[e];
+			result.triangles[offset + e] = points[partition.triangles[e]];
+			result.halfedges[offset + e] = opposite == Triangulation::InvalidIndex ? opposite : offset + opposite;
+		}
+	});
+}
+
+std::size_t
+PartitionedDelaunay::getMemoryUsage() const
+{
+	std::size_t size = (myPointOffsets.capacity() + myHalfedgeOffsets.capacity()) * sizeof(std::size_t) +
+		(myPoints.capacity() + myOrder.capacity()) * sizeof(uint32_t);
+	for (const Worker& worker : myWorkers) {
+		size += worker.sweepHull.getMemoryUsage() + worker.divideAndConquer.getMemoryUsage() +
+			worker.coords.capacity() * sizeof(float);
+	}
+	for (const Triangulation& partition : myResults) {
+		size += (partition.triangles.capacity() + partition.halfedges.capacity()) * sizeof(std::size_t);
+	}
+	return size;
+}
+
+void
+PartitionedDelaunay::releaseMemory()
+{
+	std::vector<Worker>().swap(myWorkers);
+	std::vector<std::size_t>().swap(myPointOffsets);
+	std::vector<uint32_t>().swap(myPoints);
+	std::vector<uint32_t>().swap(myOrder);
+	std::vector<Triangulation>().swap(myResults);
+	std::vector<std::size_t>().swap(myHalfedgeOffsets);
+}
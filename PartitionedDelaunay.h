@@ -0,0 +1,59 @@
+#pragma once
+
+#include "DivideAndConquerDelaunay.h"
+#include "SweepHullDelaunay.h"
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class ThreadPool;
+
+
+// Triangulates many separate groups of points at once, each on its own.
+// The points are sorted by partition in one counting pass, then every thread of the
+// pool keeps taking the largest partition left until none is, with its own engine
+// so the work buffers are not shared. The triangulations are merged into one, with
+// the indices of the input points, so it can be used like any other triangulation.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class PartitionedDelaunay
+{
+public:
+
+	// the points in no partition are left out of the triangulation
+	static constexpr uint32_t NoPartition = std::numeric_limits<uint32_t>::max();
+
+	// partitions holds the partition of every point of coords, below numPartitions.
+	// divideAndConquer picks the engine used for every partition.
+	void triangulate(const std::vector<float>& coords, const std::vector<uint32_t>& partitions, uint32_t numPartitions,
+					 bool divideAndConquer, ThreadPool& pool, Triangulation& result);
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	struct Worker
+	{
+		SweepHullDelaunay			sweepHull;
+		DivideAndConquerDelaunay	divideAndConquer;
+		std::vector<float>			coords;
+	};
+
+	std::vector<Worker>			myWorkers;
+
+	// the points of partition p are myPoints[myPointOffsets[p]] up to myPoints[myPointOffsets[p + 1]]
+	std::vector<std::size_t>	myPointOffsets;
+	std::vector<uint32_t>		myPoints;
+
+	// the partitions from the largest to the smallest
+	std::vector<uint32_t>		myOrder;
+
+	std::vector<Triangulation>	myResults;
+	std::vector<std::size_t>	myHalfedgeOffsets;
+};
@@ -0,0 +1,211 @@
+#include "PolygonMask.h"
+#include "Predicates.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// below this many triangles per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+
+	// the grid has about one cell per edge, up to this many cells on a side
+	const int32_t MaxResolution = 1024;
+}
+
+PolygonMask::PolygonMask() :
+	myMin(),
+	myCellSize(),
+	myResolution()
+{
+}
+
+bool
+PolygonMask::crossesOddly(std::size_t cell, float u0, float v0, float u1, float v1) const
+{
+	// points exactly on a line count as being on its right, which keeps the count
+	// consistent when a segment is cut in two
+	bool odd = false;
+	for (uint32_t i = myCellOffsets[cell]; i < myCellOffsets[cell + 1]; i++) {
+		const uint32_t edge = myCellEdges[i];
+		const float* p0 = &myCoords[2 * myEdges[2 * edge]];
+		const float* p1 = &myCoords[2 * myEdges[2 * edge + 1]];
+
+		const bool side0 = Predicates::orient2d(u0, v0, u1, v1, p0[0], p0[1]) > 0.0;
+		const bool side1 = Predicates::orient2d(u0, v0, u1, v1, p1[0], p1[1]) > 0.0;
+		if (side0 == side1) {
+			continue;
+		}
+		const bool startSide = Predicates::orient2d(p0[0], p0[1], p1[0], p1[1], u0, v0) > 0.0;
+		const bool endSide = Predicates::orient2d(p0[0], p0[1], p1[0], p1[1], u1, v1) > 0.0;
+		odd ^= startSide != endSide;
+	}
+	return odd;
+}
+
+void
+PolygonMask::build(const std::vector<float>& coords, const std::vector<int32_t>& edges)
+{
+	const std::size_t numPoints = coords.size() / 2;
+	myCoords = coords;
+	myEdges.clear();
+	for (std::size_t i = 0; i + 1 < edges.size(); i += 2) {
+		if (edges[i] >= 0 && edges[i + 1] >= 0 &&
+			static_cast<std::size_t>(edges[i]) < numPoints && static_cast<std::size_t>(edges[i + 1]) < numPoints) {
+			myEdges.push_back(edges[i]);
+			myEdges.push_back(edges[i + 1]);
+		}
+	}
+
+	const std::size_t numEdges = myEdges.size() / 2;
+	myResolution[0] = myResolution[1] = 0;
+	myCellOffsets.clear();
+	myCellEdges.clear();
+	myCellInside.clear();
+	if (numEdges == 0) {
+		return;
+	}
+
+	float max[2] = { myCoords[2 * myEdges[0]], myCoords[2 * myEdges[0] + 1] };
+	myMin[0] = max[0];
+	myMin[1] = max[1];
+	for (int32_t point : myEdges) {
+		for (int axis = 0; axis < 2; axis++) {
+			myMin[axis] = std::min(myMin[axis], myCoords[2 * point + axis]);
+			max[axis] = std::max(max[axis], myCoords[2 * point + axis]);
+		}
+	}
+
+	const int32_t side = std::min<int32_t>(MaxResolution, static_cast<int32_t>(std::ceil(std::sqrt(static_cast<double>(numEdges)))));
+	for (int axis = 0; axis < 2; axis++) {
+		myResolution[axis] = std::max<int32_t>(1, side);
+		myCellSize[axis] = (max[axis] - myMin[axis]) / myResolution[axis];
+		if (!(myCellSize[axis] > 0.0f)) {
+			myCellSize[axis] = 1.0f;
+		}
+	}
+
+	auto cellOf = [&](float value, int axis) {
+		const float cell = std::floor((value - myMin[axis]) / myCellSize[axis]);
+		return static_cast<int32_t>(std::min(std::max(cell, 0.0f), static_cast<float>(myResolution[axis] - 1)));
+	};
+
+	// every edge goes in the cells overlapping its bounds, counted first then written
+	const std::size_t numCells = static_cast<std::size_t>(myResolution[0]) * myResolution[1];
+	myCellOffsets.assign(numCells + 1, 0);
+	for (int pass = 0; pass < 2; pass++) {
+		for (uint32_t edge = 0; edge < numEdges; edge++) {
+			const float* p0 = &myCoords[2 * myEdges[2 * edge]];
+			const float* p1 = &myCoords[2 * myEdges[2 * edge + 1]];
+			const int32_t beginU = cellOf(std::min(p0[0], p1[0]), 0);
+			const int32_t endU = cellOf(std::max(p0[0], p1[0]), 0);
+			const int32_t beginV = cellOf(std::min(p0[1], p1[1]), 1);
+			const int32_t endV = cellOf(std::max(p0[1], p1[1]), 1);
+			for (int32_t j = beginV; j <= endV; j++) {
+				for (int32_t i = beginU; i <= endU; i++) {
+					const std::size_t cell = static_cast<std::size_t>(j) * myResolution[0] + i;
+					if (pass == 0) {
+						myCellOffsets[cell + 1]++;
+					} else {
+						myCellEdges[myCellOffsets[cell]++] = edge;
+					}
+				}
+			}
+		}
+
+		if (pass == 0) {
+			for (std::size_t cell = 0; cell < numCells; cell++) {
+				myCellOffsets[cell + 1] += myCellOffsets[cell];
+			}
+			myCellEdges.resize(myCellOffsets[numCells]);
+		} else {
+			// writing moved every offset to the start of the next cell
+			for (std::size_t cell = numCells; cell > 0; cell--) {
+				myCellOffsets[cell] = myCellOffsets[cell - 1];
+			}
+			myCellOffsets[0] = 0;
+		}
+	}
+
+	// walk every row of cell centers from the outside of the bounds, each half of
+	// a step only crosses the edges of its own cell
+	myCellInside.resize(numCells);
+	for (int32_t j = 0; j < myResolution[1]; j++) {
+		const float v = myMin[1] + (j + 0.5f) * myCellSize[1];
+		float previous = myMin[0] - myCellSize[0];
+		bool inside = false;
+		for (int32_t i = 0; i < myResolution[0]; i++) {
+			const std::size_t cell = static_cast<std::size_t>(j) * myResolution[0] + i;
+			const float border = myMin[0] + i * myCellSize[0];
+			const float center = border + 0.5f * myCellSize[0];
+			if (i > 0) {
+				inside ^= crossesOddly(cell - 1, previous, v, border, v);
+				previous = border;
+			}
+			inside ^= crossesOddly(cell, previous, v, center, v);
+			myCellInside[cell] = inside;
+			previous = center;
+		}
+	}
+}
+
+bool
+PolygonMask::isInside(float u, float v) const
+{
+	if (myCellInside.empty() ||
+		u < myMin[0] || v < myMin[1] ||
+		u > myMin[0] + myResolution[0] * myCellSize[0] || v > myMin[1] + myResolution[1] * myCellSize[1]) {
+		return false;
+	}
+
+	const int32_t i = std::min(static_cast<int32_t>((u - myMin[0]) / myCellSize[0]), myResolution[0] - 1);
+	const int32_t j = std::min(static_cast<int32_t>((v - myMin[1]) / myCellSize[1]), myResolution[1] - 1);
+	const std::size_t cell = static_cast<std::size_t>(j) * myResolution[0] + i;
+	const float centerU = myMin[0] + (i + 0.5f) * myCellSize[0];
+	const float centerV = myMin[1] + (j + 0.5f) * myCellSize[1];
+	return (myCellInside[cell] != 0) != crossesOddly(cell, centerU, centerV, u, v);
+}
+
+const std::vector<uint8_t>&
+PolygonMask::classify(const std::vector<float>& coords, const Triangulation& triangulation,
+					  bool removeInside, ThreadPool& pool)
+{
+	const std::vector<std::size_t>& triangles = triangulation.triangles;
+	const std::size_t numTriangles = triangles.size() / 3;
+	myRemoved.resize(numTriangles);
+
+	const std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numTriangles / MinChunkSize));
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		for (std::size_t t = numTriangles * chunk / numChunks; t < numTriangles * (chunk + 1) / numChunks; t++) {
+			const std::size_t a = triangles[3 * t];
+			const std::size_t b = triangles[3 * t + 1];
+			const std::size_t c = triangles[3 * t + 2];
+			const float u = (coords[2 * a] + coords[2 * b] + coords[2 * c]) / 3.0f;
+			const float v = (coords[2 * a + 1] + coords[2 * b + 1] + coords[2 * c + 1]) / 3.0f;
+			myRemoved[t] = isInside(u, v) == removeInside;
+		}
+	});
+	return myRemoved;
+}
+
+std::size_t
+PolygonMask::getMemoryUsage() const
+{
+	return myCoords.capacity() * sizeof(float) +
+		myEdges.capacity() * sizeof(int32_t) +
+		(myCellOffsets.capacity() + myCellEdges.capacity()) * sizeof(uint32_t) +
+		(myCellInside.capacity() + myRemoved.capacity()) * sizeof(uint8_t);
+}
+
+void
+PolygonMask::releaseMemory()
+{
+	std::vector<float>().swap(myCoords);
+	std::vector<int32_t>().swap(myEdges);
+	std::vector<uint32_t>().swap(myCellOffsets);
+	std::vector<uint32_t>().swap(myCellEdges);
+	std::vector<uint8_t>().swap(myCellInside);
+	std::vector<uint8_t>().swap(myRemoved);
+	myResolution[0] = myResolution[1] = 0;
+}
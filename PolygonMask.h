@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+
+// Closed polygons in the plane of the triangulation, telling which triangles are
+// inside of them with the even-odd rule.
+// The edges are bucketed in a uniform grid, and every cell knows whether its center
+// is inside, so a point is tested against the edges of its own cell only: the inside
+// state flips for every edge crossed on the way from the center of the cell to the point.
+// The grid is meant to be built once and kept while the polygons don't change.
+class PolygonMask
+{
+public:
+
+	PolygonMask();
+
+	// coords holds u0, v0, u1, v1, ... of the points of the polygons,
+	// edges two point indices per edge of the polygons
+	void build(const std::vector<float>& coords, const std::vector<int32_t>& edges);
+
+	// one byte per triangle, set for the triangles whose centroid is inside of the
+	// polygons, or outside of them when removeInside is false
+	const std::vector<uint8_t>& classify(const std::vector<float>& coords, const Triangulation& triangulation,
+										 bool removeInside, ThreadPool& pool);
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system, build must be called again
+	void releaseMemory();
+
+private:
+
+	bool isInside(float u, float v) const;
+
+	// the number of edges crossing the segment from u0, v0 to u1, v1 is odd,
+	// only looking at the edges of the cell
+	bool crossesOddly(std::size_t cell, float u0, float v0, float u1, float v1) const;
+
+	std::vector<float>			myCoords;
+	std::vector<int32_t>		myEdges;
+
+	float						myMin[2];
+	float						myCellSize[2];
+	int32_t						myResolution[2];
+
+	// the edges overlapping every cell, those of cell c start at myCellOffsets[c]
+	std::vector<uint32_t>		myCellOffsets;
+	std::vector<uint32_t>		myCellEdges;
+
+	// whether the center of every cell is inside
+	std::vector<uint8_t>		myCellInside;
+
+	std::vector<uint8_t>		myRemoved;
+};
@@ -0,0 +1,201 @@
+#include "Predicates.h"
+
+#include <algorithm>
+
+// An expansion is a sum of doubles sorted by increasing magnitude that do not overlap,
+// which represents a number exactly. The routines below come from Shewchuk's paper,
+// in their zero eliminating flavour so the expansions stay as short as possible.
+namespace
+{
+	// enough for the in circle determinant of the differences of float coordinates
+	const int MaxLength = 1536;
+
+	inline void
+	twoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		const double bVirtual = x - a;
+		const double aVirtual = x - bVirtual;
+		y = (a - aVirtual) + (b - bVirtual);
+	}
+
+	inline void
+	fastTwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		y = b - (x - a);
+	}
+
+	inline void
+	twoProduct(double a, double b, double& x, double& y)
+	{
+		x = a * b;
+		y = std::fma(a, b, -x);
+	}
+
+	// h = e + b, h may be e
+	int
+	growExpansion(int elen, const double* e, double b, double* h)
+	{
+		double q = b;
+		int hlen = 0;
+		for (int i = 0; i < elen; i++) {
+			double hh;
+			twoSum(q, e[i], q, hh);
+			if (hh != 0.0) {
+				h[hlen++] = hh;
+			}
+		}
+		if (q != 0.0 || hlen == 0) {
+			h[hlen++] = q;
+		}
+		return hlen;
+	}
+
+	// h = e + f, h may be e but not f
+	int
+	sumExpansions(int elen, const double* e, int flen, const double* f, double* h)
+	{
+		if (h != e) {
+			std::copy(e, e + elen, h);
+		}
+		int hlen = elen;
+		for (int i = 0; i < flen; i++) {
+			hlen = growExpansion(hlen, h, f[i], h);
+		}
+		return hlen;
+	}
+
+	// h = e * b
+	int
+	scaleExpansion(int elen, const double* e, double b, double* h)
+	{
+		double q, hh;
+		int hlen = 0;
+		twoProduct(e[0], b, q, hh);
+		if (hh != 0.0) {
+			h[hlen++] = hh;
+		}
+		for (int i = 1; i < elen; i++) {
+			double product1, product0, sum;
+			twoProduct(e[i], b, product1, product0);
+			twoSum(q, product0, sum, hh);
+			if (hh != 0.0) {
+				h[hlen++] = hh;
+			}
+			fastTwoSum(product1, sum, q, hh);
+			if (hh != 0.0) {
+				h[hlen++] = hh;
+			}
+		}
+		if (q != 0.0 || hlen == 0) {
+			h[hlen++] = q;
+		}
+		return hlen;
+	}
+
+	// h = e * f
+	int
+	multiplyExpansions(int elen, const double* e, int flen, const double* f, double* h)
+	{
+		double scaled[MaxLength];
+		int hlen = 1;
+		h[0] = 0.0;
+		for (int i = 0; i < flen; i++) {
+			int scaledLen = scaleExpansion(elen, e, f[i], scaled);
+			hlen = sumExpansions(hlen, h, scaledLen, scaled, h);
+		}
+		return hlen;
+	}
+
+	// h = a - b, exactly
+	inline int
+	difference(float a, float b, double* h)
+	{
+		twoSum(a, -static_cast<double>(b), h[1], h[0]);
+		if (h[0] == 0.0) {
+			h[0] = h[1];
+			return 1;
+		}
+		return 2;
+	}
+
+	// h = a * d - b * c
+	int
+	crossProduct(int alen, const double* a, int blen, const double* b,
+				 int clen, const double* c, int dlen, const double* d, double* h)
+	{
+		double ad[8];
+		double bc[8];
+		int adLen = multiplyExpansions(alen, a, dlen, d, ad);
+		int bcLen = multiplyExpansions(blen, b, clen, c, bc);
+		for (int i = 0; i < bcLen; i++) {
+			bc[i] = -bc[i];
+		}
+		return sumExpansions(adLen, ad, bcLen, bc, h);
+	}
+
+	// h = x * x + y * y
+	int
+	lift(int xlen, const double* x, int ylen, const double* y, double* h)
+	{
+		double xx[8];
+		double yy[8];
+		int xxLen = multiplyExpansions(xlen, x, xlen, x, xx);
+		int yyLen = multiplyExpansions(ylen, y, ylen, y, yy);
+		return sumExpansions(xxLen, xx, yyLen, yy, h);
+	}
+}
+
+double
+Predicates::orient2dExact(float ax, float ay, float bx, float by, float cx, float cy)
+{
+	double acx[2], acy[2], bcx[2], bcy[2];
+	int acxLen = difference(ax, cx, acx);
+	int acyLen = difference(ay, cy, acy);
+	int bcxLen = difference(bx, cx, bcx);
+	int bcyLen = difference(by, cy, bcy);
+
+	double det[16];
+	int detLen = crossProduct(acxLen, acx, acyLen, acy, bcxLen, bcx, bcyLen, bcy, det);
+	return det[detLen - 1];
+}
+
+double
+Predicates::inCircleExact(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy)
+{
+	double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+	int adxLen = difference(ax, dx, adx);
+	int adyLen = difference(ay, dy, ady);
+	int bdxLen = difference(bx, dx, bdx);
+	int bdyLen = difference(by, dy, bdy);
+	int cdxLen = difference(cx, dx, cdx);
+	int cdyLen = difference(cy, dy, cdy);
+
+	double lifted[16];
+	double cross[16];
+	double det[MaxLength];
+	double term[512];
+	int detLen = 1;
+	det[0] = 0.0;
+
+	// alift * (bdx * cdy - cdx * bdy)
+	int liftedLen = lift(adxLen, adx, adyLen, ady, lifted);
+	int crossLen = crossProduct(bdxLen, bdx, bdyLen, bdy, cdxLen, cdx, cdyLen, cdy, cross);
+	int termLen = multiplyExpansions(liftedLen, lifted, crossLen, cross, term);
+	detLen = sumExpansions(detLen, det, termLen, term, det);
+
+	// blift * (cdx * ady - adx * cdy)
+	liftedLen = lift(bdxLen, bdx, bdyLen, bdy, lifted);
+	crossLen = crossProduct(cdxLen, cdx, cdyLen, cdy, adxLen, adx, adyLen, ady, cross);
+	termLen = multiplyExpansions(liftedLen, lifted, crossLen, cross, term);
+	detLen = sumExpansions(detLen, det, termLen, term, det);
+
+	// clift * (adx * bdy - bdx * ady)
+	liftedLen = lift(cdxLen, cdx, cdyLen, cdy, lifted);
+	crossLen = crossProduct(adxLen, adx, adyLen, ady, bdxLen, bdx, bdyLen, bdy, cross);
+	termLen = multiplyExpansions(liftedLen, lifted, crossLen, cross, term);
+	detLen = sumExpansions(detLen, det, termLen, term, det);
+
+	return det[detLen - 1];
+}
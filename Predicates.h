@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cmath>
+
+
+// Geometric predicates on float coordinates.
+// They are first evaluated in float, then in double when the result is within the
+// rounding error bound (from Shewchuk's "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates"), and only when the double
+// result is still uncertain they are evaluated exactly with floating point expansions.
+// Only the sign of the returned values is meaningful.
+namespace Predicates
+{
+	// half an ulp of 1.0f and of 1.0
+	const float Epsilon = 5.9604645e-08f;
+	const double EpsilonDouble = 1.1102230246251565e-16;
+
+	const float OrientErrorBound = (3.0f + 16.0f * Epsilon) * Epsilon;
+	const float InCircleErrorBound = (10.0f + 96.0f * Epsilon) * Epsilon;
+	const double OrientErrorBoundDouble = (3.0 + 16.0 * EpsilonDouble) * EpsilonDouble;
+	const double InCircleErrorBoundDouble = (10.0 + 96.0 * EpsilonDouble) * EpsilonDouble;
+
+	double orient2dExact(float ax, float ay, float bx, float by, float cx, float cy);
+
+	double inCircleExact(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy);
+
+	inline double
+	orient2dDouble(float ax, float ay, float bx, float by, float cx, float cy)
+	{
+		const double detLeft = (static_cast<double>(ax) - cx) * (static_cast<double>(by) - cy);
+		const double detRight = (static_cast<double>(ay) - cy) * (static_cast<double>(bx) - cx);
+		const double det = detLeft - detRight;
+		const double detSum = std::fabs(detLeft) + std::fabs(detRight);
+
+		if (std::fabs(det) > OrientErrorBoundDouble * detSum) {
+			return det;
+		}
+
+		return orient2dExact(ax, ay, bx, by, cx, cy);
+	}
+
+	// positive when a, b, c turn counter clockwise, negative when clockwise, zero when aligned
+	inline double
+	orient2d(float ax, float ay, float bx, float by, float cx, float cy)
+	{
+		const float detLeft = (ax - cx) * (by - cy);
+		const float detRight = (ay - cy) * (bx - cx);
+		const float det = detLeft - detRight;
+		const float detSum = std::fabs(detLeft) + std::fabs(detRight);
+
+		if (std::fabs(det) > OrientErrorBound * detSum) {
+			return det;
+		}
+
+		return orient2dDouble(ax, ay, bx, by, cx, cy);
+	}
+
+	inline double
+	inCircleDouble(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy)
+	{
+		const double adx = static_cast<double>(ax) - dx;
+		const double ady = static_cast<double>(ay) - dy;
+		const double bdx = static_cast<double>(bx) - dx;
+		const double bdy = static_cast<double>(by) - dy;
+		const double cdx = static_cast<double>(cx) - dx;
+		const double cdy = static_cast<double>(cy) - dy;
+
+		const double bdxcdy = bdx * cdy;
+		const double cdxbdy = cdx * bdy;
+		const double alift = adx * adx + ady * ady;
+
+		const double cdxady = cdx * ady;
+		const double adxcdy = adx * cdy;
+		const double blift = bdx * bdx + bdy * bdy;
+
+		const double adxbdy = adx * bdy;
+		const double bdxady = bdx * ady;
+		const double clift = cdx * cdx + cdy * cdy;
+
+		const double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+		const double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift +
+								 (std::fabs(cdxady) + std::fabs(adxcdy)) * blift +
+								 (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+
+		if (std::fabs(det) > InCircleErrorBoundDouble * permanent) {
+			return det;
+		}
+
+		return inCircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+	}
+
+	// positive when d is inside the circle going through the counter clockwise triangle a, b, c
+	inline double
+	inCircle(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy)
+	{
+		const float adx = ax - dx;
+		const float ady = ay - dy;
+		const float bdx = bx - dx;
+		const float bdy = by - dy;
+		const float cdx = cx - dx;
+		const float cdy = cy - dy;
+
+		const float bdxcdy = bdx * cdy;
+		const float cdxbdy = cdx * bdy;
+		const float alift = adx * adx + ady * ady;
+
+		const float cdxady = cdx * ady;
+		const float adxcdy = adx * cdy;
+		const float blift = bdx * bdx + bdy * bdy;
+
+		const float adxbdy = adx * bdy;
+		const float bdxady = bdx * ady;
+		const float clift = cdx * cdx + cdy * cdy;
+
+		const float det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+		const float permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift +
+								(std::fabs(cdxady) + std::fabs(adxcdy)) * blift +
+								(std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+
+		// also catches the overflows, the comparison is false for infinities and nans
+		if (std::fabs(det) > InCircleErrorBound * permanent) {
+			return det;
+		}
+
+		return inCircleDouble(ax, ay, bx, by, cx, cy, dx, dy);
+	}
+}
@@ -0,0 +1,551 @@
+#include "Projection.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define PROJECTION_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// msvc lets any function use the avx2 intrinsics
+#define PROJECTION_AVX2
+#else
+#define PROJECTION_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// below this many points per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+
+	// the two axes kept in the plane, in the same order as the points used to be built
+	inline int
+	getUAxis(int droppedAxis)
+	{
+		return droppedAxis == 0 ? 1 : 0;
+	}
+
+	inline int
+	getVAxis(int droppedAxis)
+	{
+		return droppedAxis == 2 ? 1 : 2;
+	}
+
+	void
+	projectScalar(const float* positions, std::size_t begin, std::size_t end, int droppedAxis,
+				  float* coords, ProjectionStats& stats)
+	{
+		const int uAxis = getUAxis(droppedAxis);
+		const int vAxis = getVAxis(droppedAxis);
+		for (std::size_t i = begin; i < end; i++) {
+			const float* p = positions + 3 * i;
+			for (int axis = 0; axis < 3; axis++) {
+				stats.min[axis] = std::min(stats.min[axis], p[axis]);
+				stats.max[axis] = std::max(stats.max[axis], p[axis]);
+				stats.sum[axis] += p[axis];
+			}
+			coords[2 * i] = p[uAxis];
+			coords[2 * i + 1] = p[vAxis];
+		}
+	}
+
+#ifdef PROJECTION_X86
+	// turns x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 into x0 x1 x2 x3 | y0 y1 y2 y3 | z0 z1 z2 z3,
+	// the same shuffles work in each 128 bit lane of the avx registers
+	inline void
+	deinterleave(__m128 a, __m128 b, __m128 c, __m128* xyz)
+	{
+		__m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		__m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 z23 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		xyz[0] = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+		xyz[1] = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+		xyz[2] = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	PROJECTION_AVX2 inline void
+	deinterleave(__m256 a, __m256 b, __m256 c, __m256* xyz)
+	{
+		__m256 x23 = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		__m256 y01 = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m256 y23 = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		__m256 z01 = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		__m256 z23 = _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		xyz[0] = _mm256_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+		xyz[1] = _mm256_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+		xyz[2] = _mm256_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	void
+	mergeLanes(const float* minLanes, const float* maxLanes, const double* sumLanes,
+			   int numLanes, int axis, ProjectionStats& stats)
+	{
+		for (int i = 0; i < numLanes; i++) {
+			stats.min[axis] = std::min(stats.min[axis], minLanes[i]);
+			stats.max[axis] = std::max(stats.max[axis], maxLanes[i]);
+			stats.sum[axis] += sumLanes[i];
+		}
+	}
+
+	// returns the number of points it projected, always a multiple of 4
+	template<int DroppedAxis>
+	std::size_t
+	projectSse(const float* positions, std::size_t numPoints, float* coords, ProjectionStats& stats)
+	{
+		const int uAxis = getUAxis(DroppedAxis);
+		const int vAxis = getVAxis(DroppedAxis);
+
+		__m128 minV[3], maxV[3];
+		__m128d sumLow[3], sumHigh[3];
+		for (int axis = 0; axis < 3; axis++) {
+			minV[axis] = _mm_set1_ps(stats.min[axis]);
+			maxV[axis] = _mm_set1_ps(stats.max[axis]);
+			sumLow[axis] = _mm_setzero_pd();
+			sumHigh[axis] = _mm_setzero_pd();
+		}
+
+		const std::size_t end = numPoints & ~static_cast<std::size_t>(3);
+		for (std::size_t i = 0; i < end; i += 4) {
+			const float* p = positions + 3 * i;
+			__m128 xyz[3];
+			deinterleave(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _mm_loadu_ps(p + 8), xyz);
+
+			for (int axis = 0; axis < 3; axis++) {
+				minV[axis] = _mm_min_ps(minV[axis], xyz[axis]);
+				maxV[axis] = _mm_max_ps(maxV[axis], xyz[axis]);
+				sumLow[axis] = _mm_add_pd(sumLow[axis], _mm_cvtps_pd(xyz[axis]));
+				sumHigh[axis] = _mm_add_pd(sumHigh[axis], _mm_cvtps_pd(_mm_movehl_ps(xyz[axis], xyz[axis])));
+			}
+
+			_mm_storeu_ps(coords + 2 * i, _mm_unpacklo_ps(xyz[uAxis], xyz[vAxis]));
+			_mm_storeu_ps(coords + 2 * i + 4, _mm_unpackhi_ps(xyz[uAxis], xyz[vAxis]));
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			float minLanes[4], maxLanes[4];
+			double sumLanes[4];
+			_mm_storeu_ps(minLanes, minV[axis]);
+			_mm_storeu_ps(maxLanes, maxV[axis]);
+			_mm_storeu_pd(sumLanes, sumLow[axis]);
+			_mm_storeu_pd(sumLanes + 2, sumHigh[axis]);
+			mergeLanes(minLanes, maxLanes, sumLanes, 4, axis, stats);
+		}
+		return end;
+	}
+
+	// returns the number of points it projected, always a multiple of 8
+	template<int DroppedAxis>
+	PROJECTION_AVX2 std::size_t
+	projectAvx2(const float* positions, std::size_t numPoints, float* coords, ProjectionStats& stats)
+	{
+		const int uAxis = getUAxis(DroppedAxis);
+		const int vAxis = getVAxis(DroppedAxis);
+
+		__m256 minV[3], maxV[3];
+		__m256d sumLow[3], sumHigh[3];
+		for (int axis = 0; axis < 3; axis++) {
+			minV[axis] = _mm256_set1_ps(stats.min[axis]);
+			maxV[axis] = _mm256_set1_ps(stats.max[axis]);
+			sumLow[axis] = _mm256_setzero_pd();
+			sumHigh[axis] = _mm256_setzero_pd();
+		}
+
+		const std::size_t end = numPoints & ~static_cast<std::size_t>(7);
+		for (std::size_t i = 0; i < end; i += 8) {
+			// the low lanes get the points i to i + 3 and the high lanes the points i + 4 to i + 7
+			const float* p = positions + 3 * i;
+			__m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1);
+			__m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+			__m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+			__m256 xyz[3];
+			deinterleave(a, b, c, xyz);
+
+			for (int axis = 0; axis < 3; axis++) {
+				minV[axis] = _mm256_min_ps(minV[axis], xyz[axis]);
+				maxV[axis] = _mm256_max_ps(maxV[axis], xyz[axis]);
+				sumLow[axis] = _mm256_add_pd(sumLow[axis], _mm256_cvtps_pd(_mm256_castps256_ps128(xyz[axis])));
+				sumHigh[axis] = _mm256_add_pd(sumHigh[axis], _mm256_cvtps_pd(_mm256_extractf128_ps(xyz[axis], 1)));
+			}
+
+			__m256 low = _mm256_unpacklo_ps(xyz[uAxis], xyz[vAxis]);
+			__m256 high = _mm256_unpackhi_ps(xyz[uAxis], xyz[vAxis]);
+			_mm256_storeu_ps(coords + 2 * i, _mm256_permute2f128_ps(low, high, 0x20));
+			_mm256_storeu_ps(coords + 2 * i + 8, _mm256_permute2f128_ps(low, high, 0x31));
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			float minLanes[8], maxLanes[8];
+			double sumLanes[8];
+			_mm256_storeu_ps(minLanes, minV[axis]);
+			_mm256_storeu_ps(maxLanes, maxV[axis]);
+			_mm256_storeu_pd(sumLanes, sumLow[axis]);
+			_mm256_storeu_pd(sumLanes + 4, sumHigh[axis]);
+			mergeLanes(minLanes, maxLanes, sumLanes, 8, axis, stats);
+		}
+		return end;
+	}
+
+	bool
+	hasAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+
+		// the os also has to save the avx registers
+		__cpuid(info, 1);
+		const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+		if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx || (_xgetbv(0) & 6) != 6) {
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	template<int DroppedAxis>
+	std::size_t
+	projectSimd(const float* positions, std::size_t numPoints, float* coords, ProjectionStats& stats)
+	{
+		static const bool useAvx2 = hasAvx2();
+		if (useAvx2) {
+			return projectAvx2<DroppedAxis>(positions, numPoints, coords, stats);
+		}
+		return projectSse<DroppedAxis>(positions, numPoints, coords, stats);
+	}
+#endif
+}
+
+namespace
+{
+	inline float
+	dot(const float* a, const float* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	inline void
+	cross(const float* a, const float* b, float* result)
+	{
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	inline bool
+	normalize(float* a)
+	{
+		const float length = std::sqrt(dot(a, a));
+		if (!(length > 0.0f) || !std::isfinite(length)) {
+			return false;
+		}
+		for (int i = 0; i < 3; i++) {
+			a[i] /= length;
+		}
+		return true;
+	}
+
+	std::size_t
+	getNumChunks(std::size_t numPoints, ThreadPool& pool)
+	{
+		return std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numPoints / MinChunkSize));
+	}
+
+	void
+	resetStats(std::size_t numPoints, ProjectionStats& stats)
+	{
+		for (int axis = 0; axis < 3; axis++) {
+			stats.min[axis] = std::numeric_limits<float>::max();
+			stats.max[axis] = std::numeric_limits<float>::lowest();
+			stats.sum[axis] = 0.0;
+		}
+		stats.numPoints = numPoints;
+	}
+
+	// sorts the eigen values of the symmetric matrix a by decreasing order,
+	// with the eigen vectors in the columns of vectors, using Jacobi rotations
+	void
+	eigenDecomposition(double a[3][3], double values[3], double vectors[3][3])
+	{
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				vectors[i][j] = i == j ? 1.0 : 0.0;
+			}
+		}
+
+		for (int sweep = 0; sweep < 50; sweep++) {
+			const double offDiagonal = std::fabs(a[0][1]) + std::fabs(a[0][2]) + std::fabs(a[1][2]);
+			if (offDiagonal == 0.0) {
+				break;
+			}
+
+			for (int p = 0; p < 2; p++) {
+				for (int q = p + 1; q < 3; q++) {
+					if (a[p][q] == 0.0) {
+						continue;
+					}
+
+					// rotate in the p, q plane to zero a[p][q]
+					const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					const double c = 1.0 / std::sqrt(t * t + 1.0);
+					const double s = t * c;
+
+					for (int k = 0; k < 3; k++) {
+						const double akp = a[k][p];
+						const double akq = a[k][q];
+						a[k][p] = c * akp - s * akq;
+						a[k][q] = s * akp + c * akq;
+					}
+					for (int k = 0; k < 3; k++) {
+						const double apk = a[p][k];
+						const double aqk = a[q][k];
+						a[p][k] = c * apk - s * aqk;
+						a[q][k] = s * apk + c * aqk;
+					}
+					for (int k = 0; k < 3; k++) {
+						const double vkp = vectors[k][p];
+						const double vkq = vectors[k][q];
+						vectors[k][p] = c * vkp - s * vkq;
+						vectors[k][q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		int order[3] = { 0, 1, 2 };
+		std::sort(order, order + 3, [&](int i, int j) { return a[i][i] > a[j][j]; });
+
+		double sorted[3][3];
+		for (int j = 0; j < 3; j++) {
+			values[j] = a[order[j]][order[j]];
+			for (int i = 0; i < 3; i++) {
+				sorted[i][j] = vectors[i][order[j]];
+			}
+		}
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				vectors[i][j] = sorted[i][j];
+			}
+		}
+	}
+}
+
+void
+projectPoints(const float* positions, std::size_t numPoints, int droppedAxis,
+			  float* coords, ProjectionStats& stats)
+{
+	resetStats(numPoints, stats);
+
+	std::size_t done = 0;
+#ifdef PROJECTION_X86
+	switch (droppedAxis) {
+
+	case 0:
+		done = projectSimd<0>(positions, numPoints, coords, stats);
+		break;
+
+	case 1:
+		done = projectSimd<1>(positions, numPoints, coords, stats);
+		break;
+
+	case 2:
+	default:
+		done = projectSimd<2>(positions, numPoints, coords, stats);
+		break;
+	}
+#endif
+
+	// the points left over after the last full register
+	projectScalar(positions, done, numPoints, droppedAxis, coords, stats);
+}
+
+void
+makePlane(const float* origin, const float* normal, ProjectionPlane& plane)
+{
+	for (int i = 0; i < 3; i++) {
+		plane.origin[i] = origin[i];
+		plane.normal[i] = normal[i];
+	}
+	if (!normalize(plane.normal)) {
+		plane.normal[0] = 0.0f;
+		plane.normal[1] = 0.0f;
+		plane.normal[2] = 1.0f;
+	}
+
+	// start from the x axis, or the y axis when it is too close to the normal,
+	// so that a normal along z gives back the XY plane
+	float helper[3] = { 1.0f, 0.0f, 0.0f };
+	if (std::fabs(plane.normal[0]) > 0.9f) {
+		helper[0] = 0.0f;
+		helper[1] = 1.0f;
+	}
+
+	const float along = dot(helper, plane.normal);
+	for (int i = 0; i < 3; i++) {
+		plane.u[i] = helper[i] - along * plane.normal[i];
+	}
+	normalize(plane.u);
+	cross(plane.normal, plane.u, plane.v);
+}
+
+void
+fitPlane(const float* positions, std::size_t numPoints, ThreadPool& pool, ProjectionPlane& plane)
+{
+	const float zero[3] = { 0.0f, 0.0f, 0.0f };
+	const float up[3] = { 0.0f, 0.0f, 1.0f };
+	if (numPoints == 0) {
+		makePlane(zero, up, plane);
+		return;
+	}
+
+	// the sums are relative to the first point, which keeps the covariance
+	// accurate when the points are far from the origin
+	const double shift[3] = { positions[0], positions[1], positions[2] };
+
+	struct Moments
+	{
+		double		sum[3];
+		double		products[6];
+	};
+
+	const std::size_t numChunks = getNumChunks(numPoints, pool);
+	std::vector<Moments> chunkMoments(numChunks);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		Moments moments = {};
+		for (std::size_t i = numPoints * chunk / numChunks; i < numPoints * (chunk + 1) / numChunks; i++) {
+			const double x = positions[3 * i] - shift[0];
+			const double y = positions[3 * i + 1] - shift[1];
+			const double z = positions[3 * i + 2] - shift[2];
+			moments.sum[0] += x;
+			moments.sum[1] += y;
+			moments.sum[2] += z;
+			moments.products[0] += x * x;
+			moments.products[1] += x * y;
+			moments.products[2] += x * z;
+			moments.products[3] += y * y;
+			moments.products[4] += y * z;
+			moments.products[5] += z * z;
+		}
+		chunkMoments[chunk] = moments;
+	});
+
+	Moments total = {};
+	for (const Moments& moments : chunkMoments) {
+		for (int i = 0; i < 3; i++) {
+			total.sum[i] += moments.sum[i];
+		}
+		for (int i = 0; i < 6; i++) {
+			total.products[i] += moments.products[i];
+		}
+	}
+
+	const double count = static_cast<double>(numPoints);
+	double mean[3];
+	for (int i = 0; i < 3; i++) {
+		mean[i] = total.sum[i] / count;
+	}
+
+	double covariance[3][3];
+	const int productIndex[3][3] = { { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			covariance[i][j] = total.products[productIndex[i][j]] / count - mean[i] * mean[j];
+		}
+	}
+
+	double values[3];
+	double vectors[3][3];
+	eigenDecomposition(covariance, values, vectors);
+
+	const float origin[3] = {
+		static_cast<float>(shift[0] + mean[0]),
+		static_cast<float>(shift[1] + mean[1]),
+		static_cast<float>(shift[2] + mean[2])
+	};
+	float normal[3];
+	float u[3];
+	for (int i = 0; i < 3; i++) {
+		normal[i] = static_cast<float>(vectors[i][2]);
+		u[i] = static_cast<float>(vectors[i][0]);
+	}
+
+	// the sign of an eigen vector is arbitrary, make the normal point towards
+	// the positive side of its largest component so the result is stable
+	int largest = 0;
+	for (int i = 1; i < 3; i++) {
+		if (std::fabs(normal[i]) > std::fabs(normal[largest])) {
+			largest = i;
+		}
+	}
+	if (normal[largest] < 0.0f) {
+		for (int i = 0; i < 3; i++) {
+			normal[i] = -normal[i];
+		}
+	}
+	makePlane(origin, normal, plane);
+
+	// use the direction of largest spread as u when the points do spread
+	if (values[0] > 0.0 && normalize(u)) {
+		for (int i = 0; i < 3; i++) {
+			plane.u[i] = u[i];
+		}
+		cross(plane.normal, plane.u, plane.v);
+	}
+}
+
+void
+projectPointsOnPlane(const float* positions, std::size_t numPoints, const ProjectionPlane& plane,
+					 ThreadPool& pool, float* coords, ProjectionStats& stats)
+{
+	resetStats(numPoints, stats);
+
+	const std::size_t numChunks = getNumChunks(numPoints, pool);
+	std::vector<ProjectionStats> chunkStats(numChunks);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		ProjectionStats& local = chunkStats[chunk];
+		resetStats(0, local);
+
+		const float* axes[3] = { plane.u, plane.v, plane.normal };
+		for (std::size_t i = numPoints * chunk / numChunks; i < numPoints * (chunk + 1) / numChunks; i++) {
+			const float offset[3] = {
+				positions[3 * i] - plane.origin[0],
+				positions[3 * i + 1] - plane.origin[1],
+				positions[3 * i + 2] - plane.origin[2]
+			};
+
+			float local3d[3];
+			for (int axis = 0; axis < 3; axis++) {
+				local3d[axis] = dot(offset, axes[axis]);
+				local.min[axis] = std::min(local.min[axis], local3d[axis]);
+				local.max[axis] = std::max(local.max[axis], local3d[axis]);
+				local.sum[axis] += local3d[axis];
+			}
+			coords[2 * i] = local3d[0];
+			coords[2 * i + 1] = local3d[1];
+		}
+	});
+
+	for (const ProjectionStats& local : chunkStats) {
+		for (int axis = 0; axis < 3; axis++) {
+			stats.min[axis] = std::min(stats.min[axis], local.min[axis]);
+			stats.max[axis] = std::max(stats.max[axis], local.max[axis]);
+			stats.sum[axis] += local.sum[axis];
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+class ThreadPool;
+
+
+// Bounds and sums of the three axes of the points, gathered while projecting them.
+struct ProjectionStats
+{
+	float		min[3];
+	float		max[3];
+	double		sum[3];
+	std::size_t	numPoints;
+};
+
+// Writes the two coordinates of every point which are not on droppedAxis (0 for x, 1 for y, 2 for z)
+// to coords as u0, v0, u1, v1, ... and fills stats in the same pass over the points.
+// positions holds x0, y0, z0, x1, ... and coords must have room for 2 * numPoints floats.
+// Runs with AVX2 or SSE depending on what the processor supports.
+void projectPoints(const float* positions, std::size_t numPoints, int droppedAxis,
+				   float* coords, ProjectionStats& stats);
+
+// An orthonormal frame, the points are triangulated in its u, v plane.
+struct ProjectionPlane
+{
+	float		origin[3];
+	float		u[3];
+	float		v[3];
+	float		normal[3];
+};
+
+// Builds the frame of the plane going through origin with the given normal.
+// A null normal gives the XY plane.
+void makePlane(const float* origin, const float* normal, ProjectionPlane& plane);
+
+// Fits a plane through the centroid of the points, orthogonal to the direction in
+// which they spread the least. The covariance of the points is reduced in parallel.
+void fitPlane(const float* positions, std::size_t numPoints, ThreadPool& pool, ProjectionPlane& plane);
+
+// Like projectPoints, with the coordinates in the frame of the plane, the normal being the dropped axis.
+// The stats are in the frame of the plane too.
+void projectPointsOnPlane(const float* positions, std::size_t numPoints, const ProjectionPlane& plane,
+						  ThreadPool& pool, float* coords, ProjectionStats& stats);
@@ -0,0 +1,619 @@
+#include "SweepHullDelaunay.h"
+#include "Predicates.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const std::size_t InvalidIndex = Triangulation::InvalidIndex;
+
+	// points added between two looks at the clock when resuming
+	const std::size_t PointsPerCheck = 1024;
+
+	// when resuming, the points are sorted by blocks of this size which are then merged
+	const std::size_t SortBlockSize = 1 << 16;
+
+	inline std::size_t
+	fastMod(std::size_t i, std::size_t c)
+	{
+		return i >= c ? i % c : i;
+	}
+
+	inline double
+	dist(double ax, double ay, double bx, double by)
+	{
+		const double dx = ax - bx;
+		const double dy = ay - by;
+		return dx * dx + dy * dy;
+	}
+
+	inline double
+	circumradius(double ax, double ay, double bx, double by, double cx, double cy)
+	{
+		const double dx = bx - ax;
+		const double dy = by - ay;
+		const double ex = cx - ax;
+		const double ey = cy - ay;
+
+		const double bl = dx * dx + dy * dy;
+		const double cl = ex * ex + ey * ey;
+		const double d = dx * ey - dy * ex;
+
+		const double x = (ey * bl - dy * cl) * 0.5 / d;
+		const double y = (dx * cl - ex * bl) * 0.5 / d;
+
+		if ((bl > 0.0 || bl < 0.0) && (cl > 0.0 || cl < 0.0) && (d > 0.0 || d < 0.0)) {
+			return x * x + y * y;
+		}
+		return std::numeric_limits<double>::max();
+	}
+
+	inline bool
+	orient(float px, float py, float qx, float qy, float rx, float ry)
+	{
+		return Predicates::orient2d(px, py, qx, qy, rx, ry) > 0.0;
+	}
+
+	inline void
+	circumcenter(double ax, double ay, double bx, double by, double cx, double cy, double& x, double& y)
+	{
+		const double dx = bx - ax;
+		const double dy = by - ay;
+		const double ex = cx - ax;
+		const double ey = cy - ay;
+
+		const double bl = dx * dx + dy * dy;
+		const double cl = ex * ex + ey * ey;
+		const double d = dx * ey - dy * ex;
+
+		x = ax + (ey * bl - dy * cl) * 0.5 / d;
+		y = ay + (dx * cl - ex * bl) * 0.5 / d;
+	}
+
+	// the triangles are clockwise, so p is inside when the predicate is negative
+	inline bool
+	inCircle(float ax, float ay, float bx, float by, float cx, float cy, float px, float py)
+	{
+		return Predicates::inCircle(ax, ay, bx, by, cx, cy, px, py) < 0.0;
+	}
+
+	// the predicates are exact, so only points at the very same place can't be triangulated
+	inline bool
+	checkPointsEqual(float x1, float y1, float x2, float y2)
+	{
+		return x1 == x2 && y1 == y2;
+	}
+
+	// monotonically increases with the real angle, but doesn't need expensive trigonometry
+	inline double
+	pseudoAngle(double dx, double dy)
+	{
+		const double p = dx / (std::abs(dx) + std::abs(dy));
+		return (dy > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+	}
+
+	template <typename T>
+	std::size_t
+	capacityBytes(const std::vector<T>& v)
+	{
+		return v.capacity() * sizeof(T);
+	}
+
+	template <typename T>
+	void
+	release(std::vector<T>& v)
+	{
+		std::vector<T>().swap(v);
+	}
+}
+
+SweepHullDelaunay::SweepHullDelaunay() :
+	myCoords(nullptr),
+	myResult(nullptr),
+	mySeed{ InvalidIndex, InvalidIndex, InvalidIndex },
+	myNext(0),
+	myEnd(0),
+	myLastX(0.0f),
+	myLastY(0.0f),
+	mySortedBlocks(0),
+	myMergeWidth(0),
+	myMergeStart(0),
+	mySorted(false),
+	myHullStart(0),
+	myHashSize(0),
+	myCenterX(0.0),
+	myCenterY(0.0)
+{
+}
+
+std::size_t
+SweepHullDelaunay::getMemoryUsage() const
+{
+	return capacityBytes(myIds) + capacityBytes(myMergeIds) + capacityBytes(myDists) +
+		capacityBytes(myHullPrev) + capacityBytes(myHullNext) + capacityBytes(myHullTri) +
+		capacityBytes(myHash) + capacityBytes(myEdgeStack);
+}
+
+void
+SweepHullDelaunay::releaseMemory()
+{
+	release(myIds);
+	release(myMergeIds);
+	release(myDists);
+	release(myHullPrev);
+	release(myHullNext);
+	release(myHullTri);
+	release(myHash);
+	release(myEdgeStack);
+}
+
+void
+SweepHullDelaunay::triangulate(const std::vector<float>& coords, Triangulation& result)
+{
+	begin(coords, result);
+	resume(std::chrono::steady_clock::time_point::max());
+}
+
+void
+SweepHullDelaunay::begin(const std::vector<float>& coords, Triangulation& result)
+{
+	myCoords = &coords;
+	myResult = &result;
+	myNext = 0;
+	myEnd = 0;
+	result.triangles.clear();
+	result.halfedges.clear();
+
+	const std::size_t n = coords.size() >> 1;
+	if (n < 3) {
+		return;
+	}
+
+	double maxX = std::numeric_limits<double>::lowest();
+	double maxY = std::numeric_limits<double>::lowest();
+	double minX = std::numeric_limits<double>::max();
+	double minY = std::numeric_limits<double>::max();
+
+	myIds.resize(n);
+	for (std::size_t i = 0; i < n; i++) {
+		const double x = coords[2 * i];
+		const double y = coords[2 * i + 1];
+
+		minX = std::min(x, minX);
+		minY = std::min(y, minY);
+		maxX = std::max(x, maxX);
+		maxY = std::max(y, maxY);
+
+		myIds[i] = i;
+	}
+	const double cx = (minX + maxX) / 2;
+	const double cy = (minY + maxY) / 2;
+	double minDist = std::numeric_limits<double>::max();
+
+	std::size_t i0 = InvalidIndex;
+	std::size_t i1 = InvalidIndex;
+	std::size_t i2 = InvalidIndex;
+
+	// pick a seed point close to the centroid
+	for (std::size_t i = 0; i < n; i++) {
+		const double d = dist(cx, cy, coords[2 * i], coords[2 * i + 1]);
+		if (d < minDist) {
+			i0 = i;
+			minDist = d;
+		}
+	}
+
+	const float i0x = coords[2 * i0];
+	const float i0y = coords[2 * i0 + 1];
+
+	minDist = std::numeric_limits<double>::max();
+
+	// find the point closest to the seed
+	for (std::size_t i = 0; i < n; i++) {
+		if (i == i0) continue;
+		const double d = dist(i0x, i0y, coords[2 * i], coords[2 * i + 1]);
+		if (d < minDist && d > 0.0) {
+			i1 = i;
+			minDist = d;
+		}
+	}
+
+	// all the points are the same
+	if (i1 == InvalidIndex) {
+		return;
+	}
+
+	float i1x = coords[2 * i1];
+	float i1y = coords[2 * i1 + 1];
+
+	double minRadius = std::numeric_limits<double>::max();
+
+	// find the third point which forms the smallest circumcircle with the first two
+	for (std::size_t i = 0; i < n; i++) {
+		if (i == i0 || i == i1) continue;
+
+		const double r = circumradius(i0x, i0y, i1x, i1y, coords[2 * i], coords[2 * i + 1]);
+		if (r < minRadius) {
+			i2 = i;
+			minRadius = r;
+		}
+	}
+
+	// all the points are aligned, there is no triangle to make
+	if (!(minRadius < std::numeric_limits<double>::max())) {
+		return;
+	}
+
+	float i2x = coords[2 * i2];
+	float i2y = coords[2 * i2 + 1];
+
+	if (orient(i0x, i0y, i1x, i1y, i2x, i2y)) {
+		std::swap(i1, i2);
+		std::swap(i1x, i2x);
+		std::swap(i1y, i2y);
+	}
+
+	circumcenter(i0x, i0y, i1x, i1y, i2x, i2y, myCenterX, myCenterY);
+
+	// sort the points by distance from the seed triangle circumcenter,
+	// the distances are computed once instead of in every comparison
+	myDists.resize(n);
+	for (std::size_t i = 0; i < n; i++) {
+		myDists[i] = dist(coords[2 * i], coords[2 * i + 1], myCenterX, myCenterY);
+	}
+	mySortedBlocks = 0;
+	myMergeWidth = 0;
+	myMergeStart = 0;
+	mySorted = false;
+
+	// initialize a hash table for storing edges of the advancing convex hull
+	myHashSize = static_cast<std::size_t>(std::llround(std::ceil(std::sqrt(n))));
+	myHash.assign(myHashSize, InvalidIndex);
+
+	// initialize arrays for tracking the edges of the advancing convex hull
+	myHullPrev.resize(n);
+	myHullNext.resize(n);
+	myHullTri.resize(n);
+
+	myHullStart = i0;
+
+	myHullNext[i0] = myHullPrev[i2] = i1;
+	myHullNext[i1] = myHullPrev[i0] = i2;
+	myHullNext[i2] = myHullPrev[i1] = i0;
+
+	myHullTri[i0] = 0;
+	myHullTri[i1] = 1;
+	myHullTri[i2] = 2;
+
+	myHash[hashKey(i0x, i0y)] = i0;
+	myHash[hashKey(i1x, i1y)] = i1;
+	myHash[hashKey(i2x, i2y)] = i2;
+
+	std::size_t maxTriangles = 2 * n - 5;
+	result.triangles.reserve(maxTriangles * 3);
+	result.halfedges.reserve(maxTriangles * 3);
+	addTriangle(i0, i1, i2, InvalidIndex, InvalidIndex, InvalidIndex);
+
+	// the points are added by resume
+	mySeed[0] = i0;
+	mySeed[1] = i1;
+	mySeed[2] = i2;
+	myEnd = n;
+	myLastX = std::numeric_limits<float>::quiet_NaN();
+	myLastY = std::numeric_limits<float>::quiet_NaN();
+}
+
+bool
+SweepHullDelaunay::isCloser(std::size_t i, std::size_t j) const
+{
+	const std::vector<float>& coords = *myCoords;
+	const double diff1 = myDists[i] - myDists[j];
+	const double diff2 = coords[2 * i] - coords[2 * j];
+	const double diff3 = coords[2 * i + 1] - coords[2 * j + 1];
+
+	if (diff1 > 0.0 || diff1 < 0.0) {
+		return diff1 < 0;
+	} else if (diff2 > 0.0 || diff2 < 0.0) {
+		return diff2 < 0;
+	} else {
+		return diff3 < 0;
+	}
+}
+
+bool
+SweepHullDelaunay::sortIds(std::chrono::steady_clock::time_point deadline)
+{
+	if (mySorted) {
+		return true;
+	}
+
+	auto closer = [this](std::size_t i, std::size_t j) { return isCloser(i, j); };
+	const std::size_t n = myIds.size();
+	if (deadline == std::chrono::steady_clock::time_point::max() && mySortedBlocks == 0) {
+		std::sort(myIds.begin(), myIds.end(), closer);
+		mySorted = true;
+		return true;
+	}
+
+	// a bottom up merge sort which can stop after any block or merge,
+	// always doing one step so every call makes progress
+	bool progressed = false;
+	while (myMergeWidth == 0) {
+		const std::size_t begin = mySortedBlocks * SortBlockSize;
+		if (begin >= n) {
+			myMergeWidth = SortBlockSize;
+			myMergeStart = 0;
+			myMergeIds.resize(n);
+			break;
+		}
+		if (progressed && std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+		std::sort(myIds.begin() + begin, myIds.begin() + std::min(n, begin + SortBlockSize), closer);
+		mySortedBlocks++;
+		progressed = true;
+	}
+
+	while (myMergeWidth < n) {
+		if (progressed && std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+		const std::size_t middle = std::min(n, myMergeStart + myMergeWidth);
+		const std::size_t end = std::min(n, myMergeStart + 2 * myMergeWidth);
+		std::merge(myIds.begin() + myMergeStart, myIds.begin() + middle, myIds.begin() + middle, myIds.begin() + end,
+				   myMergeIds.begin() + myMergeStart, closer);
+		myMergeStart = end;
+		if (myMergeStart >= n) {
+			myIds.swap(myMergeIds);
+			myMergeWidth *= 2;
+			myMergeStart = 0;
+		}
+		progressed = true;
+	}
+
+	mySorted = true;
+	return true;
+}
+
+bool
+SweepHullDelaunay::resume(std::chrono::steady_clock::time_point deadline)
+{
+	if (myNext >= myEnd) {
+		return true;
+	}
+
+	// the points are added from the closest to the seed triangle
+	if (!sortIds(deadline)) {
+		return false;
+	}
+
+	const std::vector<float>& coords = *myCoords;
+	const float i0x = coords[2 * mySeed[0]];
+	const float i0y = coords[2 * mySeed[0] + 1];
+	const float i1x = coords[2 * mySeed[1]];
+	const float i1y = coords[2 * mySeed[1] + 1];
+	const float i2x = coords[2 * mySeed[2]];
+	const float i2y = coords[2 * mySeed[2] + 1];
+	const bool limited = deadline != std::chrono::steady_clock::time_point::max();
+	const std::size_t first = myNext;
+
+	for (; myNext < myEnd; myNext++) {
+		const std::size_t k = myNext;
+		if (limited && k > first && (k - first) % PointsPerCheck == 0 && std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+
+		const std::size_t i = myIds[k];
+		const float x = coords[2 * i];
+		const float y = coords[2 * i + 1];
+
+		// skip duplicate points
+		if (k > 0 && checkPointsEqual(x, y, myLastX, myLastY)) continue;
+		myLastX = x;
+		myLastY = y;
+
+		// skip seed triangle points
+		if (checkPointsEqual(x, y, i0x, i0y) ||
+			checkPointsEqual(x, y, i1x, i1y) ||
+			checkPointsEqual(x, y, i2x, i2y)) continue;
+
+		// find a visible edge on the convex hull using edge hash
+		std::size_t start = 0;
+
+		std::size_t key = hashKey(x, y);
+		for (std::size_t j = 0; j < myHashSize; j++) {
+			start = myHash[fastMod(key + j, myHashSize)];
+			if (start != InvalidIndex && start != myHullNext[start]) break;
+		}
+
+		start = myHullPrev[start];
+		std::size_t e = start;
+		std::size_t q;
+
+		while (q = myHullNext[e], !orient(x, y, coords[2 * e], coords[2 * e + 1], coords[2 * q], coords[2 * q + 1])) {
+			e = q;
+			if (e == start) {
+				e = InvalidIndex;
+				break;
+			}
+		}
+
+		// likely a near-duplicate point; skip it
+		if (e == InvalidIndex) continue;
+
+		// add the first triangle from the point
+		std::size_t t = addTriangle(e, i, myHullNext[e], InvalidIndex, InvalidIndex, myHullTri[e]);
+
+		// recursively flip triangles from the point until they satisfy the Delaunay condition
+		myHullTri[i] = legalize(t + 2);
+		myHullTri[e] = t;
+
+		// walk forward through the hull, adding more triangles and flipping recursively
+		std::size_t next = myHullNext[e];
+		while (q = myHullNext[next], orient(x, y, coords[2 * next], coords[2 * next + 1], coords[2 * q], coords[2 * q + 1])) {
+			t = addTriangle(next, i, q, myHullTri[i], InvalidIndex, myHullTri[next]);
+			myHullTri[i] = legalize(t + 2);
+			myHullNext[next] = next; // mark as removed
+			next = q;
+		}
+
+		// walk backward from the other side, adding more triangles and flipping
+		if (e == start) {
+			while (q = myHullPrev[e], orient(x, y, coords[2 * q], coords[2 * q + 1], coords[2 * e], coords[2 * e + 1])) {
+				t = addTriangle(q, i, e, InvalidIndex, myHullTri[e], myHullTri[q]);
+				legalize(t + 2);
+				myHullTri[q] = t;
+				myHullNext[e] = e; // mark as removed
+				e = q;
+			}
+		}
+
+		// update the hull indices
+		myHullPrev[i] = e;
+		myHullStart = e;
+		myHullPrev[next] = i;
+		myHullNext[e] = i;
+		myHullNext[i] = next;
+
+		myHash[hashKey(x, y)] = i;
+		myHash[hashKey(coords[2 * e], coords[2 * e + 1])] = e;
+	}
+	return true;
+}
+
+std::size_t
+SweepHullDelaunay::legalize(std::size_t a)
+{
+	const std::vector<float>& coords = *myCoords;
+	std::vector<std::size_t>& triangles = myResult->triangles;
+	std::vector<std::size_t>& halfedges = myResult->halfedges;
+
+	std::size_t i = 0;
+	std::size_t ar = 0;
+	myEdgeStack.clear();
+
+	// the recursion of the original algorithm is replaced by a stack of edges
+	while (true) {
+		const std::size_t b = halfedges[a];
+
+		// if the pair of triangles doesn't satisfy the Delaunay condition
+		// (p1 is inside the circumcircle of [p0, pl, pr]), flip them,
+		// then do the same check/flip for the new pair of triangles
+		const std::size_t a0 = 3 * (a / 3);
+		ar = a0 + (a + 2) % 3;
+
+		if (b == InvalidIndex) {
+			if (i > 0) {
+				i--;
+				a = myEdgeStack[i];
+				continue;
+			} else {
+				break;
+			}
+		}
+
+		const std::size_t b0 = 3 * (b / 3);
+		const std::size_t al = a0 + (a + 1) % 3;
+		const std::size_t bl = b0 + (b + 2) % 3;
+
+		const std::size_t p0 = triangles[ar];
+		const std::size_t pr = triangles[a];
+		const std::size_t pl = triangles[al];
+		const std::size_t p1 = triangles[bl];
+
+		const bool illegal = inCircle(
+			coords[2 * p0], coords[2 * p0 + 1],
+			coords[2 * pr], coords[2 * pr + 1],
+			coords[2 * pl], coords[2 * pl + 1],
+			coords[2 * p1], coords[2 * p1 + 1]);
+
+		if (illegal) {
+			triangles[a] = p1;
+			triangles[b] = p0;
+
+			std::size_t hbl = halfedges[bl];
+
+			// edge swapped on the other side of the hull (rare); fix the halfedge reference
+			if (hbl == InvalidIndex) {
+				std::size_t e = myHullStart;
+				do {
+					if (myHullTri[e] == bl) {
+						myHullTri[e] = a;
+						break;
+					}
+					e = myHullPrev[e];
+				} while (e != myHullStart);
+			}
+			link(a, hbl);
+			link(b, halfedges[ar]);
+			link(ar, bl);
+
+			std::size_t br = b0 + (b + 1) % 3;
+
+			if (i < myEdgeStack.size()) {
+				myEdgeStack[i] = br;
+			} else {
+				myEdgeStack.push_back(br);
+			}
+			i++;
+
+		} else {
+			if (i > 0) {
+				i--;
+				a = myEdgeStack[i];
+				continue;
+			} else {
+				break;
+			}
+		}
+	}
+	return ar;
+}
+
+std::size_t
+SweepHullDelaunay::hashKey(double x, double y) const
+{
+	const double dx = x - myCenterX;
+	const double dy = y - myCenterY;
+	return fastMod(
+		static_cast<std::size_t>(std::llround(std::floor(pseudoAngle(dx, dy) * static_cast<double>(myHashSize)))),
+		myHashSize);
+}
+
+std::size_t
+SweepHullDelaunay::addTriangle(std::size_t i0, std::size_t i1, std::size_t i2,
+							   std::size_t a, std::size_t b, std::size_t c)
+{
+	std::size_t t = myResult->triangles.size();
+	myResult->triangles.push_back(i0);
+	myResult->triangles.push_back(i1);
+	myResult->triangles.push_back(i2);
+	link(t, a);
+	link(t + 1, b);
+	link(t + 2, c);
+	return t;
+}
+
+void
+SweepHullDelaunay::link(std::size_t a, std::size_t b)
+{
+	std::vector<std::size_t>& halfedges = myResult->halfedges;
+
+	std::size_t s = halfedges.size();
+	if (a == s) {
+		halfedges.push_back(b);
+	} else {
+		halfedges[a] = b;
+	}
+
+	if (b != InvalidIndex) {
+		std::size_t s2 = halfedges.size();
+		if (b == s2) {
+			halfedges.push_back(a);
+		} else {
+			halfedges[b] = a;
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+
+// Sweep hull delaunay triangulation, ported from delaunator-cpp (MIT license,
+// https://github.com/delfrrr/delaunator-cpp).
+// Unlike delaunator::Delaunator the object is meant to be kept between cooks:
+// every work buffer keeps its capacity, so triangulating a similar number of
+// points again doesn't allocate anything.
+class SweepHullDelaunay
+{
+public:
+
+	SweepHullDelaunay();
+
+	// coords holds x0, y0, x1, y1, ... like for delaunator::Delaunator, but in single precision.
+	// The result is empty when all the points are aligned or there are less than 3.
+	void triangulate(const std::vector<float>& coords, Triangulation& result);
+
+	// the same in steps: begin sorts the points and makes the seed triangle, then every
+	// resume adds points until they are all in or the deadline passed. coords and result
+	// must not change in between, result is only complete once resume returned true.
+	void begin(const std::vector<float>& coords, Triangulation& result);
+	bool resume(std::chrono::steady_clock::time_point deadline);
+
+	// bytes held by the work buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the work buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// sorts myIds, over several calls when there is a deadline
+	bool sortIds(std::chrono::steady_clock::time_point deadline);
+	bool isCloser(std::size_t i, std::size_t j) const;
+
+	std::size_t legalize(std::size_t a);
+	std::size_t hashKey(double x, double y) const;
+	std::size_t addTriangle(std::size_t i0, std::size_t i1, std::size_t i2,
+							std::size_t a, std::size_t b, std::size_t c);
+	void link(std::size_t a, std::size_t b);
+
+	// only valid during triangulate, or from begin until resume is done
+	const std::vector<float>*	myCoords;
+	Triangulation*				myResult;
+
+	// the seed triangle, and the next sorted point to add up to myEnd
+	std::size_t					mySeed[3];
+	std::size_t					myNext;
+	std::size_t					myEnd;
+	float						myLastX;
+	float						myLastY;
+
+	// state of the sort of myIds when it is done in steps
+	std::size_t					mySortedBlocks;
+	std::size_t					myMergeWidth;
+	std::size_t					myMergeStart;
+	bool						mySorted;
+	std::vector<std::size_t>	myMergeIds;
+
+	std::vector<std::size_t>	myIds;
+	std::vector<double>			myDists;
+	std::vector<std::size_t>	myHullPrev;
+	std::vector<std::size_t>	myHullNext;
+	std::vector<std::size_t>	myHullTri;
+	std::size_t					myHullStart;
+
+	std::vector<std::size_t>	myHash;
+	std::size_t					myHashSize;
+	double						myCenterX;
+	double						myCenterY;
+
+	std::vector<std::size_t>	myEdgeStack;
+};
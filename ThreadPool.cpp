@@ -0,0 +1,172 @@
+#include "ThreadPool.h"
+#include "CookTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool::Workers
+{
+	Workers();
+	~Workers();
+
+	void workerLoop();
+
+	std::vector<std::thread>			threads;
+	std::deque<std::function<void()>>	tasks;
+	std::mutex							mutex;
+	std::condition_variable				condition;
+	bool								stop;
+};
+
+ThreadPool::Workers::Workers() : stop(false)
+{
+	// the calling thread is the last worker
+	unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned i = 1; i < numThreads; i++) {
+		threads.emplace_back(&Workers::workerLoop, this);
+	}
+}
+
+ThreadPool::Workers::~Workers()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	condition.notify_all();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void
+ThreadPool::Workers::workerLoop()
+{
+	CookTrace::setThreadName("pool worker");
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return stop || !tasks.empty(); });
+			if (stop && tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+std::shared_ptr<ThreadPool::Workers>
+ThreadPool::acquireWorkers()
+{
+	// the last handle going away stops the threads, outside of the dll unloading
+	// where joining them could dead lock
+	static std::mutex mutex;
+	static std::weak_ptr<Workers> current;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<Workers> workers = current.lock();
+	if (!workers) {
+		workers = std::make_shared<Workers>();
+		current = workers;
+	}
+	return workers;
+}
+
+ThreadPool::ThreadPool(unsigned maxThreads) :
+	myWorkers(acquireWorkers()),
+	myMaxThreads(maxThreads)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+}
+
+void
+ThreadPool::setMaxThreads(unsigned maxThreads)
+{
+	myMaxThreads = maxThreads;
+}
+
+unsigned
+ThreadPool::getNumThreads() const
+{
+	unsigned numThreads = static_cast<unsigned>(myWorkers->threads.size()) + 1;
+	return myMaxThreads == 0 ? numThreads : std::min(numThreads, myMaxThreads);
+}
+
+void
+ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& func)
+{
+	if (count == 0) {
+		return;
+	}
+
+	if (count == 1 || getNumThreads() == 1) {
+		for (std::size_t i = 0; i < count; i++) {
+			func(i);
+		}
+		return;
+	}
+
+	// the state is shared with the helpers, which may start after we returned
+	struct Batch
+	{
+		std::atomic<std::size_t>	next{ 0 };
+		std::size_t					done = 0;
+		std::mutex					mutex;
+		std::condition_variable		finished;
+	};
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+
+	// the helpers trace to the trace of the caller, and only while they have an index,
+	// the trace may be gone once the caller returned
+	CookTrace* trace = CookTrace::getCurrent();
+	auto work = [batch, count, &func, trace]() {
+		CookTrace* previous = CookTrace::getCurrent();
+		CookTrace::setCurrent(trace);
+		const CookTrace::Clock::time_point begin = trace ? CookTrace::Clock::now() : CookTrace::Clock::time_point();
+		std::size_t processed = 0;
+		for (std::size_t i = batch->next++; i < count; i = batch->next++) {
+			func(i);
+			processed++;
+		}
+		CookTrace::setCurrent(previous);
+
+		if (processed > 0) {
+			if (trace) {
+				trace->addSpan("parallel_for", begin, CookTrace::Clock::now());
+			}
+			std::lock_guard<std::mutex> lock(batch->mutex);
+			batch->done += processed;
+			if (batch->done == count) {
+				batch->finished.notify_all();
+			}
+		}
+	};
+
+	// helpers only touch func while an index is left, so it can stay a reference
+	Workers& workers = *myWorkers;
+	std::size_t numHelpers = std::min<std::size_t>(count, getNumThreads()) - 1;
+	{
+		std::lock_guard<std::mutex> lock(workers.mutex);
+		for (std::size_t i = 0; i < numHelpers; i++) {
+			workers.tasks.emplace_back(work);
+		}
+	}
+	workers.condition.notify_all();
+
+	work();
+
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->finished.wait(lock, [&batch, count] { return batch->done == count; });
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+
+// Handle on a pool of worker threads shared by every instance of the plugin in the
+// process, so many nodes cooking in the same frame don't start a thread storm.
+// The workers start with the first handle and stop with the last one.
+// The thread calling parallelFor always takes part in the work, so a task
+// running on the pool can itself call parallelFor without dead locking.
+class ThreadPool
+{
+public:
+
+	// maxThreads counts the calling thread, 0 means one per hardware thread
+	explicit ThreadPool(unsigned maxThreads = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// limits the threads working on the parallelFor of this handle, 0 means no limit
+	void setMaxThreads(unsigned maxThreads);
+
+	// number of threads working on a parallelFor, including the caller
+	unsigned getNumThreads() const;
+
+	// call func(i) for every i in [0, count) and return once all are done
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+private:
+
+	// the threads and their queue of tasks, defined in the .cpp
+	struct Workers;
+
+	// the workers of the process, started when there are none
+	static std::shared_ptr<Workers> acquireWorkers();
+
+	std::shared_ptr<Workers>	myWorkers;
+	unsigned					myMaxThreads;
+};
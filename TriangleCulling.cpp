@@ -0,0 +1,105 @@
+#include "TriangleCulling.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// below this many triangles per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+}
+
+const std::vector<std::size_t>&
+TriangleCulling::cull(const std::vector<float>& coords, const Triangulation& triangulation,
+					  Mode mode, float threshold, const uint8_t* removed, ThreadPool& pool)
+{
+	myKept.clear();
+	if (mode == Mode::none && removed == nullptr) {
+		return triangulation.triangles;
+	}
+
+	const std::vector<std::size_t>& triangles = triangulation.triangles;
+	const std::size_t numTriangles = triangles.size() / 3;
+	const double squaredThreshold = static_cast<double>(threshold) * threshold;
+
+	const std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numTriangles / MinChunkSize));
+	myChunkOffsets.assign(numChunks + 1, 0);
+	myKept.resize(numTriangles);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t count = 0;
+		for (std::size_t t = numTriangles * chunk / numChunks; t < numTriangles * (chunk + 1) / numChunks; t++) {
+			const std::size_t a = triangles[3 * t];
+			const std::size_t b = triangles[3 * t + 1];
+			const std::size_t c = triangles[3 * t + 2];
+
+			const double abx = static_cast<double>(coords[2 * b]) - coords[2 * a];
+			const double aby = static_cast<double>(coords[2 * b + 1]) - coords[2 * a + 1];
+			const double bcx = static_cast<double>(coords[2 * c]) - coords[2 * b];
+			const double bcy = static_cast<double>(coords[2 * c + 1]) - coords[2 * b + 1];
+			const double cax = static_cast<double>(coords[2 * a]) - coords[2 * c];
+			const double cay = static_cast<double>(coords[2 * a + 1]) - coords[2 * c + 1];
+
+			const double ab = abx * abx + aby * aby;
+			const double bc = bcx * bcx + bcy * bcy;
+			const double ca = cax * cax + cay * cay;
+
+			bool kept;
+			if (removed != nullptr && removed[t]) {
+				kept = false;
+			} else if (mode == Mode::none) {
+				kept = true;
+			} else if (mode == Mode::edgeLength) {
+				kept = std::max(ab, std::max(bc, ca)) <= squaredThreshold;
+			} else {
+				// the circumradius is |ab| |bc| |ca| / (4 area), compared squared without dividing
+				const double doubleArea = abx * bcy - aby * bcx;
+				kept = ab * bc * ca <= 4.0 * doubleArea * doubleArea * squaredThreshold;
+			}
+
+			myKept[t] = kept;
+			count += kept;
+		}
+		myChunkOffsets[chunk + 1] = count;
+	});
+	for (std::size_t i = 0; i < numChunks; i++) {
+		myChunkOffsets[i + 1] += myChunkOffsets[i];
+	}
+
+	myTriangles.resize(3 * myChunkOffsets[numChunks]);
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t kept = myChunkOffsets[chunk];
+		for (std::size_t t = numTriangles * chunk / numChunks; t < numTriangles * (chunk + 1) / numChunks; t++) {
+			if (!myKept[t]) {
+				continue;
+			}
+			myTriangles[3 * kept] = triangles[3 * t];
+			myTriangles[3 * kept + 1] = triangles[3 * t + 1];
+			myTriangles[3 * kept + 2] = triangles[3 * t + 2];
+			kept++;
+		}
+	});
+
+	return myTriangles;
+}
+
+const std::vector<uint8_t>&
+TriangleCulling::getKeptMask() const
+{
+	return myKept;
+}
+
+std::size_t
+TriangleCulling::getMemoryUsage() const
+{
+	return myKept.capacity() * sizeof(uint8_t) +
+		(myChunkOffsets.capacity() + myTriangles.capacity()) * sizeof(std::size_t);
+}
+
+void
+TriangleCulling::releaseMemory()
+{
+	std::vector<uint8_t>().swap(myKept);
+	std::vector<std::size_t>().swap(myChunkOffsets);
+	std::vector<std::size_t>().swap(myTriangles);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+
+// Removes the triangles which are too large from a triangulation, along with the ones
+// a mask removed. Culling by size gives concave outlines: culling by circumradius keeps
+// the alpha shape of the points, with alpha being one over the threshold.
+// The triangles are tested in parallel and the kept ones are compacted with a prefix
+// sum over the chunks.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class TriangleCulling
+{
+public:
+
+	enum Mode { none, edgeLength, circumradius };
+
+	// returns the points of the kept triangles, 3 per triangle like Triangulation::triangles.
+	// removed is null, or holds one byte per triangle which is set to remove it whatever its size.
+	const std::vector<std::size_t>& cull(const std::vector<float>& coords, const Triangulation& triangulation,
+										 Mode mode, float threshold, const uint8_t* removed, ThreadPool& pool);
+
+	// one byte per triangle of the last culled triangulation, 0 for the removed ones.
+	// Empty when nothing was culled.
+	const std::vector<uint8_t>& getKeptMask() const;
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	std::vector<uint8_t>		myKept;
+	std::vector<std::size_t>	myChunkOffsets;
+	std::vector<std::size_t>	myTriangles;
+};
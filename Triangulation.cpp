@@ -0,0 +1,16 @@
+#include "Triangulation.h"
+
+#include <algorithm>
+
+void
+countTriangulation(const Triangulation& triangulation, std::size_t numPoints,
+				   std::vector<uint8_t>& used, TriangulationCounts& counts)
+{
+	counts.hullSize = std::count(triangulation.halfedges.begin(), triangulation.halfedges.end(), Triangulation::InvalidIndex);
+
+	used.assign(numPoints, 0);
+	for (std::size_t point : triangulation.triangles) {
+		used[point] = 1;
+	}
+	counts.numUnusedPoints = numPoints - std::count(used.begin(), used.end(), 1);
+}
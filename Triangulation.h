@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+// Result of a delaunay triangulation, with the same layout as delaunator::Delaunator:
+// triangle t is made of the points triangles[3 * t], triangles[3 * t + 1] and triangles[3 * t + 2],
+// halfedges[e] is the halfedge going the opposite way in the neighbour triangle,
+// or InvalidIndex on the hull.
+struct Triangulation
+{
+	static constexpr std::size_t InvalidIndex = std::numeric_limits<std::size_t>::max();
+
+	std::vector<std::size_t>	triangles;
+	std::vector<std::size_t>	halfedges;
+};
+
+// The size of the outline of the triangles, the hull unless triangles were removed,
+// and the points in no triangle: the duplicates the engines skip, or the points left out.
+struct TriangulationCounts
+{
+	std::size_t		hullSize = 0;
+	std::size_t		numUnusedPoints = 0;
+};
+
+// used is a buffer kept by the caller, with a byte per point
+void countTriangulation(const Triangulation& triangulation, std::size_t numPoints,
+						std::vector<uint8_t>& used, TriangulationCounts& counts);
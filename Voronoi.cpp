@@ -0,0 +1,246 @@
+#include "Voronoi.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// below this many triangles per chunk the threads cost more than they save
+	const std::size_t MinChunkSize = 1 << 14;
+
+	inline std::size_t
+	nextHalfedge(std::size_t e)
+	{
+		return (e % 3 == 2) ? e - 2 : e + 1;
+	}
+
+	// liang barsky clipping of p + t * d against one side of the rectangle
+	inline bool
+	clipSide(double p, double q, double& t0, double& t1)
+	{
+		if (p == 0.0) {
+			return q >= 0.0;
+		}
+		const double r = q / p;
+		if (p < 0.0) {
+			t0 = std::max(t0, r);
+		} else {
+			t1 = std::min(t1, r);
+		}
+		return t0 < t1;
+	}
+}
+
+bool
+VoronoiDiagram::clipEdge(const std::vector<float>& coords, const Triangulation& triangulation, std::size_t e,
+						 const float* bounds, Segment& segment) const
+{
+	const std::size_t opposite = triangulation.halfedges[e];
+	const std::size_t triangle = e / 3;
+
+	const double startU = myCenters[2 * triangle];
+	const double startV = myCenters[2 * triangle + 1];
+	double du, dv;
+	double t0 = 0.0;
+	double t1;
+
+	if (opposite != Triangulation::InvalidIndex) {
+		// the edge between the circumcenters of the two triangles
+		du = myCenters[2 * (opposite / 3)] - startU;
+		dv = myCenters[2 * (opposite / 3) + 1] - startV;
+		t1 = 1.0;
+	} else {
+		// the ray orthogonal to the hull edge, going away from the triangle
+		const std::size_t a = triangulation.triangles[e];
+		const std::size_t b = triangulation.triangles[nextHalfedge(e)];
+		const std::size_t c = triangulation.triangles[nextHalfedge(nextHalfedge(e))];
+		du = static_cast<double>(coords[2 * a + 1]) - coords[2 * b + 1];
+		dv = static_cast<double>(coords[2 * b]) - coords[2 * a];
+		if (du * (coords[2 * c] - coords[2 * a]) + dv * (coords[2 * c + 1] - coords[2 * a + 1]) > 0.0) {
+			du = -du;
+			dv = -dv;
+		}
+		t1 = std::numeric_limits<double>::infinity();
+	}
+
+	if (!std::isfinite(startU) || !std::isfinite(startV) || !std::isfinite(du) || !std::isfinite(dv)) {
+		return false;
+	}
+
+	if (!(clipSide(-du, startU - bounds[0], t0, t1) &&
+		  clipSide(du, bounds[2] - startU, t0, t1) &&
+		  clipSide(-dv, startV - bounds[1], t0, t1) &&
+		  clipSide(dv, bounds[3] - startV, t0, t1))) {
+		return false;
+	}
+
+	segment.u = startU;
+	segment.v = startV;
+	segment.du = du;
+	segment.dv = dv;
+	segment.t0 = t0;
+	segment.t1 = t1;
+	return true;
+}
+
+void
+VoronoiDiagram::build(const std::vector<float>& coords, const Triangulation& triangulation,
+					  const float* bounds, ThreadPool& pool)
+{
+	const std::vector<std::size_t>& triangles = triangulation.triangles;
+	const std::size_t numTriangles = triangles.size() / 3;
+
+	myVertices.clear();
+	myEdges.clear();
+	if (numTriangles == 0) {
+		return;
+	}
+
+	const std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(pool.getNumThreads() * 4, numTriangles / MinChunkSize));
+	myVertexOffsets.assign(numChunks + 1, 0);
+	myEdgeOffsets.assign(numChunks + 1, 0);
+	myCenters.resize(2 * numTriangles);
+	myCenterVertex.resize(numTriangles);
+
+	// the circumcenters, and how many of them are inside the bounds
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t count = 0;
+		for (std::size_t t = numTriangles * chunk / numChunks; t < numTriangles * (chunk + 1) / numChunks; t++) {
+			const std::size_t a = triangles[3 * t];
+			const std::size_t b = triangles[3 * t + 1];
+			const std::size_t c = triangles[3 * t + 2];
+
+			const double ax = coords[2 * a];
+			const double ay = coords[2 * a + 1];
+			const double dx = coords[2 * b] - ax;
+			const double dy = coords[2 * b + 1] - ay;
+			const double ex = coords[2 * c] - ax;
+			const double ey = coords[2 * c + 1] - ay;
+
+			const double bl = dx * dx + dy * dy;
+			const double cl = ex * ex + ey * ey;
+			const double d = 0.5 / (dx * ey - dy * ex);
+
+			const float u = static_cast<float>(ax + (ey * bl - dy * cl) * d);
+			const float v = static_cast<float>(ay + (dx * cl - ex * bl) * d);
+			myCenters[2 * t] = u;
+			myCenters[2 * t + 1] = v;
+
+			const bool inside = u >= bounds[0] && v >= bounds[1] && u <= bounds[2] && v <= bounds[3];
+			myCenterVertex[t] = inside ? 0 : -1;
+			count += inside;
+		}
+		myVertexOffsets[chunk + 1] = count;
+	});
+	for (std::size_t i = 0; i < numChunks; i++) {
+		myVertexOffsets[i + 1] += myVertexOffsets[i];
+	}
+
+	const std::size_t numCenterVertices = myVertexOffsets[numChunks];
+	myVertices.resize(2 * numCenterVertices);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t vertex = myVertexOffsets[chunk];
+		for (std::size_t t = numTriangles * chunk / numChunks; t < numTriangles * (chunk + 1) / numChunks; t++) {
+			if (myCenterVertex[t] < 0) {
+				continue;
+			}
+			myCenterVertex[t] = static_cast<int32_t>(vertex);
+			myVertices[2 * vertex] = myCenters[2 * t];
+			myVertices[2 * vertex + 1] = myCenters[2 * t + 1];
+			vertex++;
+		}
+	});
+
+	// an edge is handled by its smallest halfedge, its ends cut by the bounds need new vertices
+	const std::size_t numHalfedges = triangles.size();
+	auto isEdgeStart = [&](std::size_t e) {
+		return triangulation.halfedges[e] == Triangulation::InvalidIndex || e < triangulation.halfedges[e];
+	};
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t numEdges = 0;
+		std::size_t numClipped = 0;
+		for (std::size_t e = numHalfedges * chunk / numChunks; e < numHalfedges * (chunk + 1) / numChunks; e++) {
+			Segment segment;
+			if (!isEdgeStart(e) || !clipEdge(coords, triangulation, e, bounds, segment)) {
+				continue;
+			}
+			const std::size_t opposite = triangulation.halfedges[e];
+			numEdges++;
+			numClipped += !(segment.t0 == 0.0 && myCenterVertex[e / 3] >= 0);
+			numClipped += !(opposite != Triangulation::InvalidIndex && segment.t1 == 1.0 && myCenterVertex[opposite / 3] >= 0);
+		}
+		myVertexOffsets[chunk + 1] = numClipped;
+		myEdgeOffsets[chunk + 1] = numEdges;
+	});
+	myVertexOffsets[0] = numCenterVertices;
+	for (std::size_t i = 0; i < numChunks; i++) {
+		myVertexOffsets[i + 1] += myVertexOffsets[i];
+		myEdgeOffsets[i + 1] += myEdgeOffsets[i];
+	}
+
+	myVertices.resize(2 * myVertexOffsets[numChunks]);
+	myEdges.resize(2 * myEdgeOffsets[numChunks]);
+
+	pool.parallelFor(numChunks, [&](std::size_t chunk) {
+		std::size_t vertex = myVertexOffsets[chunk];
+		std::size_t edge = myEdgeOffsets[chunk];
+
+		auto addVertex = [&](const Segment& segment, double t) {
+			myVertices[2 * vertex] = static_cast<float>(segment.u + t * segment.du);
+			myVertices[2 * vertex + 1] = static_cast<float>(segment.v + t * segment.dv);
+			return static_cast<int32_t>(vertex++);
+		};
+
+		for (std::size_t e = numHalfedges * chunk / numChunks; e < numHalfedges * (chunk + 1) / numChunks; e++) {
+			Segment segment;
+			if (!isEdgeStart(e) || !clipEdge(coords, triangulation, e, bounds, segment)) {
+				continue;
+			}
+			const std::size_t triangle = e / 3;
+			const std::size_t opposite = triangulation.halfedges[e];
+
+			// the ends inside the bounds are the circumcenters themselves
+			const bool startKept = segment.t0 == 0.0 && myCenterVertex[triangle] >= 0;
+			const bool endKept = opposite != Triangulation::InvalidIndex && segment.t1 == 1.0 && myCenterVertex[opposite / 3] >= 0;
+
+			myEdges[2 * edge] = startKept ? myCenterVertex[triangle] : addVertex(segment, segment.t0);
+			myEdges[2 * edge + 1] = endKept ? myCenterVertex[opposite / 3] : addVertex(segment, segment.t1);
+			edge++;
+		}
+	});
+}
+
+const std::vector<float>&
+VoronoiDiagram::getVertices() const
+{
+	return myVertices;
+}
+
+const std::vector<int32_t>&
+VoronoiDiagram::getEdges() const
+{
+	return myEdges;
+}
+
+std::size_t
+VoronoiDiagram::getMemoryUsage() const
+{
+	return (myCenters.capacity() + myVertices.capacity()) * sizeof(float) +
+		(myCenterVertex.capacity() + myEdges.capacity()) * sizeof(int32_t) +
+		(myVertexOffsets.capacity() + myEdgeOffsets.capacity()) * sizeof(std::size_t);
+}
+
+void
+VoronoiDiagram::releaseMemory()
+{
+	std::vector<float>().swap(myCenters);
+	std::vector<int32_t>().swap(myCenterVertex);
+	std::vector<std::size_t>().swap(myVertexOffsets);
+	std::vector<std::size_t>().swap(myEdgeOffsets);
+	std::vector<float>().swap(myVertices);
+	std::vector<int32_t>().swap(myEdges);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Triangulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+
+// Voronoi diagram of the points of a delaunay triangulation, as line segments
+// clipped to a rectangle. Its vertices are the circumcenters of the triangles,
+// with an edge between the circumcenters of every two neighbour triangles and
+// a ray going out of every hull edge.
+// Like the triangulation engines, the object keeps its buffers between cooks.
+class VoronoiDiagram
+{
+public:
+
+	// bounds holds minU, minV, maxU, maxV of the clipping rectangle
+	void build(const std::vector<float>& coords, const Triangulation& triangulation,
+			   const float* bounds, ThreadPool& pool);
+
+	// u0, v0, u1, v1, ... of the vertices of the diagram
+	const std::vector<float>& getVertices() const;
+
+	// two vertex indices per edge
+	const std::vector<int32_t>& getEdges() const;
+
+	// bytes held by the buffers
+	std::size_t getMemoryUsage() const;
+
+	// give the buffers memory back to the system
+	void releaseMemory();
+
+private:
+
+	// the points start + t * direction for t in [t0, t1]
+	struct Segment
+	{
+		double		u;
+		double		v;
+		double		du;
+		double		dv;
+		double		t0;
+		double		t1;
+	};
+
+	// the part of the edge or ray going out of halfedge e which is inside the bounds,
+	// false when there is none
+	bool clipEdge(const std::vector<float>& coords, const Triangulation& triangulation, std::size_t e,
+				  const float* bounds, Segment& segment) const;
+
+	// u, v of the circumcenter of every triangle
+	std::vector<float>			myCenters;
+
+	// vertex of the circumcenter of every triangle, -1 when it is out of the bounds
+	std::vector<int32_t>		myCenterVertex;
+
+	std::vector<std::size_t>	myVertexOffsets;
+	std::vector<std::size_t>	myEdgeOffsets;
+
+	std::vector<float>			myVertices;
+	std::vector<int32_t>		myEdges;
+};
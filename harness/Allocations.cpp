@@ -0,0 +1,64 @@
+#include "Allocations.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> theNumAllocations{ 0 };
+	std::atomic<uint64_t> theAllocatedBytes{ 0 };
+}
+
+uint64_t
+getNumAllocations()
+{
+	return theNumAllocations.load();
+}
+
+uint64_t
+getAllocatedBytes()
+{
+	return theAllocatedBytes.load();
+}
+
+void*
+operator new(std::size_t size)
+{
+	theNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	theAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void*
+operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+	free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+	free(p);
+}
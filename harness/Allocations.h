@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Counts of the global operator new since the start of the process. The tools are linked
+// with -rdynamic, so the plugin allocates through the same operator and is counted too.
+uint64_t getNumAllocations();
+uint64_t getAllocatedBytes();
@@ -0,0 +1,269 @@
+// Cooks the plugin outside of TouchDesigner on made up points and prints the timings,
+// allocations and Info CHOP channels of every cook, one JSON object per line.
+//
+//	sopbench [--plugin path] [--datasets uniform,clustered,grid,circle] [--points 1000,100000]
+//			 [--samples n] [--static] [--scale s] [--fps rate] [--expect-cache-hits] [--par Name=value ...]
+//
+// A sample is the cook of a new input, or of the same input with --static, and all the
+// cooks the node asks for after it, one per frame, until it has the triangulation.
+// With --static --expect-cache-hits, it fails when a sample after the first doesn't reuse
+// the result in a single cook.
+
+#include "Allocations.h"
+#include "Datasets.h"
+#include "HostNode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Sample
+	{
+		// time spent in the cooks, and from the first cook to the end of the last
+		double		cookMs;
+		double		latencyMs;
+		double		maxCookMs;
+		int32_t		numCooks;
+		uint64_t	numAllocations;
+		uint64_t	allocatedBytes;
+	};
+
+	struct Options
+	{
+		std::string									pluginPath = "./DelaunayTriangulationSop.so";
+		std::vector<Distribution>					distributions = { Distribution::uniform, Distribution::clustered,
+																	  Distribution::grid, Distribution::circle };
+		std::vector<std::size_t>					sizes = { 1000, 10000, 100000, 1000000 };
+		int32_t										numSamples = 5;
+		bool										staticInput = false;
+		bool										expectCacheHits = false;
+
+		// the points are multiplied by it, to try the node on very small or large coordinates
+		float										scale = 1.0f;
+		double										fps = 60.0;
+		std::vector<std::pair<std::string, std::string>>	parameters;
+	};
+
+	// a sample never cooks more than this, in case the node keeps asking to cook again
+	const int32_t MaxCooksPerSample = 100000;
+
+	std::vector<std::string>
+	split(const char* text)
+	{
+		std::vector<std::string> parts;
+		std::string part;
+		for (const char* c = text; ; c++) {
+			if (*c == ',' || *c == '\0') {
+				if (!part.empty()) {
+					parts.push_back(part);
+				}
+				part.clear();
+				if (*c == '\0') {
+					break;
+				}
+			} else {
+				part += *c;
+			}
+		}
+		return parts;
+	}
+
+	bool
+	parseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (strcmp(arg, "--plugin") == 0 && hasValue) {
+				options.pluginPath = argv[++i];
+			} else if (strcmp(arg, "--datasets") == 0 && hasValue) {
+				options.distributions.clear();
+				for (const std::string& name : split(argv[++i])) {
+					Distribution distribution;
+					if (!parseDistribution(name, distribution)) {
+						fprintf(stderr, "unknown dataset %s\n", name.c_str());
+						return false;
+					}
+					options.distributions.push_back(distribution);
+				}
+			} else if (strcmp(arg, "--points") == 0 && hasValue) {
+				options.sizes.clear();
+				for (const std::string& size : split(argv[++i])) {
+					options.sizes.push_back(strtoull(size.c_str(), nullptr, 10));
+				}
+			} else if (strcmp(arg, "--samples") == 0 && hasValue) {
+				options.numSamples = std::max(1, atoi(argv[++i]));
+			} else if (strcmp(arg, "--static") == 0) {
+				options.staticInput = true;
+			} else if (strcmp(arg, "--scale") == 0 && hasValue) {
+				options.scale = static_cast<float>(atof(argv[++i]));
+			} else if (strcmp(arg, "--expect-cache-hits") == 0) {
+				options.expectCacheHits = true;
+			} else if (strcmp(arg, "--fps") == 0 && hasValue) {
+				options.fps = std::max(1.0, atof(argv[++i]));
+			} else if (strcmp(arg, "--par") == 0 && hasValue) {
+				const std::string par = argv[++i];
+				const std::size_t equal = par.find('=');
+				if (equal == std::string::npos) {
+					fprintf(stderr, "--par takes Name=value, not %s\n", par.c_str());
+					return false;
+				}
+				options.parameters.emplace_back(par.substr(0, equal), par.substr(equal + 1));
+			} else {
+				fprintf(stderr,
+						"usage: %s [--plugin path] [--datasets uniform,clustered,grid,circle] [--points 1000,100000]\n"
+						"          [--samples n] [--static] [--scale s] [--fps rate] [--expect-cache-hits] [--par Name=value ...]\n", argv[0]);
+				return false;
+			}
+		}
+		if (options.expectCacheHits && !options.staticInput) {
+			fprintf(stderr, "--expect-cache-hits needs --static\n");
+			return false;
+		}
+		return true;
+	}
+
+	float
+	getChannel(const std::vector<std::pair<std::string, float>>& channels, const char* name)
+	{
+		for (const auto& channel : channels) {
+			if (channel.first == name) {
+				return channel.second;
+			}
+		}
+		return 0.0f;
+	}
+
+	void
+	generateInput(Distribution distribution, std::size_t numPoints, uint32_t seed, float scale, HostSOPInput& input)
+	{
+		generatePoints(distribution, numPoints, seed, input.getPositions());
+		for (Position& p : input.getPositions()) {
+			p.x *= scale;
+			p.y *= scale;
+			p.z *= scale;
+		}
+		input.update();
+	}
+
+	double
+	percentile(std::vector<double> values, double fraction)
+	{
+		std::sort(values.begin(), values.end());
+		return values[static_cast<std::size_t>(fraction * (values.size() - 1) + 0.5)];
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return 2;
+	}
+
+	int result = 0;
+
+	for (Distribution distribution : options.distributions) {
+		for (std::size_t numPoints : options.sizes) {
+			// a new node for every dataset, so nothing is cached from the last one
+			HostNode node;
+			std::string error;
+			if (!node.load(options.pluginPath.c_str(), error)) {
+				fprintf(stderr, "%s\n", error.c_str());
+				return 1;
+			}
+			for (const auto& par : options.parameters) {
+				if (!node.getParameters().set(par.first, par.second)) {
+					fprintf(stderr, "can't set %s to %s\n", par.first.c_str(), par.second.c_str());
+					return 1;
+				}
+			}
+
+			HostSOPInput input;
+			generateInput(distribution, numPoints, 1, options.scale, input);
+			node.getInputs().setInput(0, &input);
+
+			HostOutput output;
+			HostVBOOutput vboOutput;
+			std::vector<std::pair<std::string, float>> channels;
+			std::vector<double> times;
+			float cacheMisses = 0.0f;
+
+			for (int32_t s = 0; s < options.numSamples; s++) {
+				if (!options.staticInput && s > 0) {
+					generateInput(distribution, numPoints, s + 1, options.scale, input);
+				}
+
+				Sample sample = {};
+				const uint64_t numAllocations = getNumAllocations();
+				const uint64_t allocatedBytes = getAllocatedBytes();
+				bool directToGPU = false;
+				bool cookAgain = true;
+
+				// a node cooking in the background or over several cooks is done once it stops asking for more
+				const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(1.0 / options.fps));
+				const auto first = std::chrono::steady_clock::now();
+				while (cookAgain && sample.numCooks < MaxCooksPerSample) {
+					std::this_thread::sleep_until(first + sample.numCooks * frameDuration);
+					node.nextFrame();
+					const auto start = std::chrono::steady_clock::now();
+					node.cook(output, vboOutput, directToGPU, cookAgain);
+					const auto end = std::chrono::steady_clock::now();
+					const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+					sample.cookMs += ms;
+					sample.maxCookMs = std::max(sample.maxCookMs, ms);
+					sample.latencyMs = std::chrono::duration<double, std::milli>(end - first).count();
+					sample.numCooks++;
+				}
+				sample.numAllocations = getNumAllocations() - numAllocations;
+				sample.allocatedBytes = getAllocatedBytes() - allocatedBytes;
+				times.push_back(sample.latencyMs);
+
+				node.getInfoChannels(channels);
+				if (options.expectCacheHits && s > 0 &&
+					(sample.numCooks != 1 || getChannel(channels, "cache_misses") != cacheMisses)) {
+					fprintf(stderr, "%s %zu points: sample %d missed the cache\n", getDistributionName(distribution), numPoints, s);
+					result = 1;
+				}
+				cacheMisses = getChannel(channels, "cache_misses");
+				printf("{\"type\":\"cook\",\"dataset\":\"%s\",\"points\":%zu,\"sample\":%d,\"cooks\":%d,"
+					   "\"cook_ms\":%.4f,\"max_cook_ms\":%.4f,\"latency_ms\":%.4f,\"points_per_second\":%.1f,"
+					   "\"allocations\":%llu,\"allocated_bytes\":%llu,\"gpu\":%s,\"output_points\":%d,\"output_triangles\":%d",
+					   getDistributionName(distribution), numPoints, s, sample.numCooks,
+					   sample.cookMs, sample.maxCookMs, sample.latencyMs,
+					   sample.latencyMs > 0.0 ? numPoints * 1000.0 / sample.latencyMs : 0.0,
+					   static_cast<unsigned long long>(sample.numAllocations), static_cast<unsigned long long>(sample.allocatedBytes),
+					   directToGPU ? "true" : "false",
+					   directToGPU ? vboOutput.getNumVertices() : static_cast<int32_t>(output.getPositions().size()),
+					   directToGPU ? vboOutput.getNumTriangles() : output.getNumTriangles());
+				printf(",\"info\":{");
+				for (std::size_t c = 0; c < channels.size(); c++) {
+					printf("%s\"%s\":%.9g", c ? "," : "", channels[c].first.c_str(), channels[c].second);
+				}
+				printf("}}\n");
+			}
+
+			const std::string warning = node.getWarning();
+			double mean = 0.0;
+			for (double time : times) {
+				mean += time / times.size();
+			}
+			printf("{\"type\":\"summary\",\"dataset\":\"%s\",\"points\":%zu,\"samples\":%d,\"static\":%s,"
+				   "\"min_latency_ms\":%.4f,\"median_latency_ms\":%.4f,\"mean_latency_ms\":%.4f,\"max_latency_ms\":%.4f,\"points_per_second\":%.1f,\"warning\":\"%s\"}\n",
+				   getDistributionName(distribution), numPoints, options.numSamples, options.staticInput ? "true" : "false",
+				   percentile(times, 0.0), percentile(times, 0.5), mean, percentile(times, 1.0),
+				   numPoints * 1000.0 / percentile(times, 0.5), warning.c_str());
+			fflush(stdout);
+		}
+	}
+	return result;
+}
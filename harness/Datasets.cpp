@@ -0,0 +1,89 @@
+#include "Datasets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const double Pi = 3.14159265358979323846;
+
+	const char* const DistributionNames[] = { "uniform", "clustered", "grid", "circle" };
+}
+
+bool
+parseDistribution(const std::string& name, Distribution& distribution)
+{
+	for (int i = 0; i < 4; i++) {
+		if (name == DistributionNames[i]) {
+			distribution = static_cast<Distribution>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char*
+getDistributionName(Distribution distribution)
+{
+	return DistributionNames[static_cast<int>(distribution)];
+}
+
+void
+generatePoints(Distribution distribution, std::size_t numPoints, uint32_t seed, std::vector<Position>& positions)
+{
+	positions.resize(numPoints);
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	switch (distribution) {
+	case Distribution::uniform:
+		for (Position& p : positions) {
+			p.x = unit(random);
+			p.y = unit(random);
+			p.z = 0.0f;
+		}
+		break;
+
+	case Distribution::clustered: {
+		// about a hundred points per cluster, each ten times smaller than the last of ten sizes
+		const std::size_t numClusters = std::max<std::size_t>(1, numPoints / 100);
+		std::vector<float> centers(3 * numClusters);
+		for (std::size_t c = 0; c < numClusters; c++) {
+			centers[3 * c] = unit(random);
+			centers[3 * c + 1] = unit(random);
+			centers[3 * c + 2] = 0.05f * std::pow(0.5f, static_cast<float>(c % 10));
+		}
+		std::uniform_int_distribution<std::size_t> cluster(0, numClusters - 1);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		for (Position& p : positions) {
+			const std::size_t c = cluster(random);
+			p.x = centers[3 * c] + centers[3 * c + 2] * normal(random);
+			p.y = centers[3 * c + 1] + centers[3 * c + 2] * normal(random);
+			p.z = 0.0f;
+		}
+		break;
+	}
+
+	case Distribution::grid: {
+		const std::size_t side = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(numPoints)))));
+		for (std::size_t i = 0; i < numPoints; i++) {
+			positions[i].x = static_cast<float>(i % side) / side;
+			positions[i].y = static_cast<float>(i / side) / side;
+			positions[i].z = 0.0f;
+		}
+		break;
+	}
+
+	case Distribution::circle: {
+		const double offset = unit(random);
+		for (std::size_t i = 0; i < numPoints; i++) {
+			const double angle = 2.0 * Pi * (i + offset) / numPoints;
+			positions[i].x = static_cast<float>(std::cos(angle));
+			positions[i].y = static_cast<float>(std::sin(angle));
+			positions[i].z = 0.0f;
+		}
+		break;
+	}
+	}
+}
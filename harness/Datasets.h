@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CPlusPlus_Common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Points made up for benchmarking, in the XY plane so the default projection of the
+// node keeps them as they are.
+enum class Distribution
+{
+	// uniform in the unit square
+	uniform,
+
+	// gaussian blobs of very different densities
+	clustered,
+
+	// a regular grid, every point cocircular with its neighbours
+	grid,
+
+	// on a circle, the worst case of the sweep hull
+	circle,
+};
+
+// false when the name is none of the distributions
+bool parseDistribution(const std::string& name, Distribution& distribution);
+
+const char* getDistributionName(Distribution distribution);
+
+// the same seed always gives the same points
+void generatePoints(Distribution distribution, std::size_t numPoints, uint32_t seed, std::vector<Position>& positions);
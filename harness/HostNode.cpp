@@ -0,0 +1,772 @@
+#include "HostNode.h"
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+//-----------------------------------------------------------------------------------------------------
+//										strings and parameters
+//-----------------------------------------------------------------------------------------------------
+
+void
+HostString::setString(const char* val)
+{
+	myValue = val ? val : "";
+}
+
+const std::string&
+HostString::get() const
+{
+	return myValue;
+}
+
+bool
+HostParameters::set(const std::string& name, const std::string& value)
+{
+	auto found = myParameters.find(name);
+	if (found == myParameters.end()) {
+		return false;
+	}
+	Parameter& parameter = found->second;
+
+	if (!parameter.menuNames.empty()) {
+		if (std::find(parameter.menuNames.begin(), parameter.menuNames.end(), value) == parameter.menuNames.end()) {
+			return false;
+		}
+		parameter.text = value;
+		return true;
+	}
+
+	if (parameter.style == "string" || parameter.style == "file") {
+		parameter.text = value;
+		return true;
+	}
+
+	// up to four numbers separated by commas
+	const char* text = value.c_str();
+	for (int i = 0; i < 4 && *text; i++) {
+		char* end = nullptr;
+		parameter.values[i] = strtod(text, &end);
+		if (end == text) {
+			return false;
+		}
+		text = *end == ',' ? end + 1 : end;
+	}
+	return *text == '\0';
+}
+
+const HostParameters::Parameter*
+HostParameters::find(const char* name) const
+{
+	auto found = myParameters.find(name);
+	return found == myParameters.end() ? nullptr : &found->second;
+}
+
+const std::map<std::string, HostParameters::Parameter>&
+HostParameters::getParameters() const
+{
+	return myParameters;
+}
+
+OP_ParAppendResult
+HostParameters::appendNumeric(const OP_NumericParameter& np, const char* style)
+{
+	if (!np.name || myParameters.count(np.name)) {
+		return OP_ParAppendResult::InvalidName;
+	}
+	Parameter& parameter = myParameters[np.name];
+	parameter.style = style;
+	for (int i = 0; i < 4; i++) {
+		parameter.values[i] = np.defaultValues[i];
+	}
+	return OP_ParAppendResult::Success;
+}
+
+OP_ParAppendResult
+HostParameters::appendText(const OP_StringParameter& sp, const char* style)
+{
+	if (!sp.name || myParameters.count(sp.name)) {
+		return OP_ParAppendResult::InvalidName;
+	}
+	Parameter& parameter = myParameters[sp.name];
+	parameter.style = style;
+	std::fill(parameter.values, parameter.values + 4, 0.0);
+	parameter.text = sp.defaultValue ? sp.defaultValue : "";
+	return OP_ParAppendResult::Success;
+}
+
+OP_ParAppendResult HostParameters::appendFloat(const OP_NumericParameter& np, int32_t) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendInt(const OP_NumericParameter& np, int32_t) { return appendNumeric(np, "int"); }
+OP_ParAppendResult HostParameters::appendXY(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendXYZ(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendUV(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendUVW(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendRGB(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendRGBA(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendToggle(const OP_NumericParameter& np) { return appendNumeric(np, "toggle"); }
+OP_ParAppendResult HostParameters::appendPulse(const OP_NumericParameter& np) { return appendNumeric(np, "pulse"); }
+OP_ParAppendResult HostParameters::appendMomentary(const OP_NumericParameter& np) { return appendNumeric(np, "toggle"); }
+OP_ParAppendResult HostParameters::appendWH(const OP_NumericParameter& np) { return appendNumeric(np, "float"); }
+OP_ParAppendResult HostParameters::appendString(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendFile(const OP_StringParameter& sp) { return appendText(sp, "file"); }
+OP_ParAppendResult HostParameters::appendFolder(const OP_StringParameter& sp) { return appendText(sp, "file"); }
+OP_ParAppendResult HostParameters::appendDAT(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendCHOP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendTOP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendObject(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendSOP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendPython(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendOP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendCOMP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendMAT(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendPanelCOMP(const OP_StringParameter& sp) { return appendText(sp, "string"); }
+OP_ParAppendResult HostParameters::appendHeader(const OP_StringParameter& sp) { return appendText(sp, "header"); }
+
+OP_ParAppendResult
+HostParameters::appendMenu(const OP_StringParameter& sp, int32_t nItems, const char** names, const char** labels)
+{
+	OP_ParAppendResult res = appendText(sp, "menu");
+	if (res == OP_ParAppendResult::Success) {
+		myParameters[sp.name].menuNames.assign(names, names + nItems);
+	}
+	return res;
+}
+
+OP_ParAppendResult
+HostParameters::appendStringMenu(const OP_StringParameter& sp, int32_t nItems, const char** names, const char** labels)
+{
+	return appendMenu(sp, nItems, names, labels);
+}
+
+//-----------------------------------------------------------------------------------------------------
+//												inputs
+//-----------------------------------------------------------------------------------------------------
+
+HostSOPInput::HostSOPInput()
+{
+	opPath = "/host/input";
+	opId = 0;
+	myPrimsInfo = nullptr;
+	myPrimPointIndices = nullptr;
+	totalCooks = 0;
+}
+
+std::vector<Position>&
+HostSOPInput::getPositions()
+{
+	return myPositions;
+}
+
+void
+HostSOPInput::clearPrimitives()
+{
+	myPrimitives.clear();
+	myPrimitivePoints.clear();
+}
+
+void
+HostSOPInput::addPrimitive(const int32_t* points, int32_t numPoints)
+{
+	SOP_PrimitiveInfo primitive;
+	primitive.numVertices = numPoints;
+	primitive.type = PrimitiveType::Polygon;
+	primitive.pointIndicesOffset = static_cast<int32_t>(myPrimitivePoints.size());
+	primitive.pointIndices = nullptr;
+	myPrimitives.push_back(primitive);
+	myPrimitivePoints.insert(myPrimitivePoints.end(), points, points + numPoints);
+}
+
+void
+HostSOPInput::clearAttributes()
+{
+	myAttributes.clear();
+}
+
+void
+HostSOPInput::setAttribute(Attribute attribute)
+{
+	for (Attribute& existing : myAttributes) {
+		if (existing.name == attribute.name) {
+			existing = std::move(attribute);
+			return;
+		}
+	}
+	myAttributes.push_back(std::move(attribute));
+}
+
+void
+HostSOPInput::setIntAttribute(const char* name, int32_t numComponents, std::vector<int32_t> values)
+{
+	Attribute attribute;
+	attribute.name = name;
+	attribute.numComponents = numComponents;
+	attribute.intValues = std::move(values);
+	setAttribute(std::move(attribute));
+}
+
+void
+HostSOPInput::setFloatAttribute(const char* name, int32_t numComponents, std::vector<float> values)
+{
+	Attribute attribute;
+	attribute.name = name;
+	attribute.numComponents = numComponents;
+	attribute.floatValues = std::move(values);
+	setAttribute(std::move(attribute));
+}
+
+void
+HostSOPInput::update()
+{
+	// the pointers into the buffers may have moved
+	for (SOP_PrimitiveInfo& primitive : myPrimitives) {
+		primitive.pointIndices = myPrimitivePoints.data() + primitive.pointIndicesOffset;
+	}
+	myPrimsInfo = myPrimitives.data();
+	myPrimPointIndices = myPrimitivePoints.data();
+
+	myAttributeData.clear();
+	for (const Attribute& attribute : myAttributes) {
+		bool isInt = !attribute.intValues.empty();
+		SOP_CustomAttribData data(attribute.name.c_str(), attribute.numComponents, isInt ? AttribType::Int : AttribType::Float);
+		data.intData = isInt ? attribute.intValues.data() : nullptr;
+		data.floatData = isInt ? nullptr : attribute.floatValues.data();
+		myAttributeData.push_back(data);
+	}
+	totalCooks++;
+}
+
+int32_t HostSOPInput::getNumPoints() const { return static_cast<int32_t>(myPositions.size()); }
+int32_t HostSOPInput::getNumVertices() const { return static_cast<int32_t>(myPrimitivePoints.size()); }
+int32_t HostSOPInput::getNumPrimitives() const { return static_cast<int32_t>(myPrimitives.size()); }
+int32_t HostSOPInput::getNumCustomAttributes() const { return static_cast<int32_t>(myAttributeData.size()); }
+const Position* HostSOPInput::getPointPositions() const { return myPositions.data(); }
+const SOP_NormalInfo* HostSOPInput::getNormals() const { return nullptr; }
+const SOP_ColorInfo* HostSOPInput::getColors() const { return nullptr; }
+const SOP_TextureInfo* HostSOPInput::getTextures() const { return nullptr; }
+bool HostSOPInput::hasNormals() const { return false; }
+bool HostSOPInput::hasColors() const { return false; }
+bool HostSOPInput::isInside(const Position&) { return false; }
+bool HostSOPInput::sendRay(const Position&, const Vector&, Position&, float&, Vector&, float&, float&, int&) { return false; }
+
+const SOP_CustomAttribData*
+HostSOPInput::getCustomAttribute(int32_t customAttribIndex) const
+{
+	if (customAttribIndex < 0 || customAttribIndex >= getNumCustomAttributes()) {
+		return nullptr;
+	}
+	return &myAttributeData[customAttribIndex];
+}
+
+const SOP_CustomAttribData*
+HostSOPInput::getCustomAttribute(const char* customAttribName) const
+{
+	for (const SOP_CustomAttribData& data : myAttributeData) {
+		if (strcmp(data.name, customAttribName) == 0) {
+			return &data;
+		}
+	}
+	return nullptr;
+}
+
+HostInputs::HostInputs(const HostParameters& parameters) : myParameters(parameters)
+{
+	memset(&myTime, 0, sizeof(myTime));
+	myTime.rate = 60.0;
+	myTime.rootRate = 60.0;
+}
+
+void
+HostInputs::setInput(int32_t index, const HostSOPInput* input)
+{
+	if (myInputs.size() <= static_cast<size_t>(index)) {
+		myInputs.resize(index + 1, nullptr);
+	}
+	myInputs[index] = input;
+	while (!myInputs.empty() && !myInputs.back()) {
+		myInputs.pop_back();
+	}
+}
+
+OP_TimeInfo&
+HostInputs::getTime()
+{
+	return myTime;
+}
+
+const HostParameters::Parameter&
+HostInputs::getParameter(const char* name) const
+{
+	// like asking TouchDesigner for a parameter the plugin didn't declare, a bug of the plugin
+	const HostParameters::Parameter* parameter = myParameters.find(name);
+	if (!parameter) {
+		throw std::runtime_error(std::string("no parameter named ") + name);
+	}
+	return *parameter;
+}
+
+int32_t
+HostInputs::getNumInputs() const
+{
+	return static_cast<int32_t>(myInputs.size());
+}
+
+double
+HostInputs::getParDouble(const char* name, int32_t index) const
+{
+	const HostParameters::Parameter& parameter = getParameter(name);
+	if (!parameter.menuNames.empty()) {
+		auto found = std::find(parameter.menuNames.begin(), parameter.menuNames.end(), parameter.text);
+		return found == parameter.menuNames.end() ? 0.0 : static_cast<double>(found - parameter.menuNames.begin());
+	}
+	return parameter.values[std::min(std::max(index, 0), 3)];
+}
+
+bool
+HostInputs::getParDouble2(const char* name, double& v0, double& v1) const
+{
+	v0 = getParDouble(name, 0);
+	v1 = getParDouble(name, 1);
+	return true;
+}
+
+bool
+HostInputs::getParDouble3(const char* name, double& v0, double& v1, double& v2) const
+{
+	getParDouble2(name, v0, v1);
+	v2 = getParDouble(name, 2);
+	return true;
+}
+
+bool
+HostInputs::getParDouble4(const char* name, double& v0, double& v1, double& v2, double& v3) const
+{
+	getParDouble3(name, v0, v1, v2);
+	v3 = getParDouble(name, 3);
+	return true;
+}
+
+int32_t
+HostInputs::getParInt(const char* name, int32_t index) const
+{
+	return static_cast<int32_t>(lround(getParDouble(name, index)));
+}
+
+bool
+HostInputs::getParInt2(const char* name, int32_t& v0, int32_t& v1) const
+{
+	v0 = getParInt(name, 0);
+	v1 = getParInt(name, 1);
+	return true;
+}
+
+bool
+HostInputs::getParInt3(const char* name, int32_t& v0, int32_t& v1, int32_t& v2) const
+{
+	getParInt2(name, v0, v1);
+	v2 = getParInt(name, 2);
+	return true;
+}
+
+bool
+HostInputs::getParInt4(const char* name, int32_t& v0, int32_t& v1, int32_t& v2, int32_t& v3) const
+{
+	getParInt3(name, v0, v1, v2);
+	v3 = getParInt(name, 3);
+	return true;
+}
+
+const char*
+HostInputs::getParString(const char* name) const
+{
+	return getParameter(name).text.c_str();
+}
+
+const char*
+HostInputs::getParFilePath(const char* name) const
+{
+	return getParameter(name).text.c_str();
+}
+
+const OP_SOPInput*
+HostInputs::getInputSOP(int32_t index) const
+{
+	return index >= 0 && index < getNumInputs() ? myInputs[index] : nullptr;
+}
+
+const OP_TimeInfo*
+HostInputs::getTimeInfo() const
+{
+	return &myTime;
+}
+
+// the plugin only uses sop inputs
+const OP_TOPInput* HostInputs::getInputTOP(int32_t) const { return nullptr; }
+const OP_CHOPInput* HostInputs::getInputCHOP(int32_t) const { return nullptr; }
+const OP_DATInput* HostInputs::getParDAT(const char*) const { return nullptr; }
+const OP_TOPInput* HostInputs::getParTOP(const char*) const { return nullptr; }
+const OP_CHOPInput* HostInputs::getParCHOP(const char*) const { return nullptr; }
+const OP_ObjectInput* HostInputs::getParObject(const char*) const { return nullptr; }
+bool HostInputs::getRelativeTransform(const char*, const char*, double[4][4]) const { return false; }
+void HostInputs::enablePar(const char*, bool) const {}
+const OP_DATInput* HostInputs::getDAT(const char*) const { return nullptr; }
+const OP_TOPInput* HostInputs::getTOP(const char*) const { return nullptr; }
+const OP_CHOPInput* HostInputs::getCHOP(const char*) const { return nullptr; }
+const OP_ObjectInput* HostInputs::getObject(const char*) const { return nullptr; }
+void* HostInputs::getTOPDataInCPUMemory(const OP_TOPInput*, const OP_TOPInputDownloadOptions*) const { return nullptr; }
+const OP_SOPInput* HostInputs::getParSOP(const char*) const { return nullptr; }
+const OP_SOPInput* HostInputs::getSOP(const char*) const { return nullptr; }
+const OP_DATInput* HostInputs::getInputDAT(int32_t) const { return nullptr; }
+PyObject* HostInputs::getParPython(const char*) const { return nullptr; }
+
+//-----------------------------------------------------------------------------------------------------
+//												outputs
+//-----------------------------------------------------------------------------------------------------
+
+HostOutput::HostOutput() : myNumLines(0)
+{
+}
+
+void
+HostOutput::clear()
+{
+	myPositions.clear();
+	myTriangles.clear();
+	myLinePoints.clear();
+	myNumLines = 0;
+}
+
+const std::vector<Position>&
+HostOutput::getPositions() const
+{
+	return myPositions;
+}
+
+int32_t
+HostOutput::getNumTriangles() const
+{
+	return static_cast<int32_t>(myTriangles.size() / 3);
+}
+
+int32_t
+HostOutput::getNumLines() const
+{
+	return myNumLines;
+}
+
+int32_t
+HostOutput::addPoint(const Position& pos)
+{
+	myPositions.push_back(pos);
+	return static_cast<int32_t>(myPositions.size()) - 1;
+}
+
+bool
+HostOutput::addPoints(const Position* pos, int32_t numPoints)
+{
+	myPositions.insert(myPositions.end(), pos, pos + numPoints);
+	return true;
+}
+
+int32_t
+HostOutput::getNumPoints()
+{
+	return static_cast<int32_t>(myPositions.size());
+}
+
+bool
+HostOutput::addTriangle(int32_t ptIdx1, int32_t ptIdx2, int32_t ptIdx3)
+{
+	myTriangles.push_back(ptIdx1);
+	myTriangles.push_back(ptIdx2);
+	myTriangles.push_back(ptIdx3);
+	return true;
+}
+
+bool
+HostOutput::addTriangles(const int32_t* indices, int32_t size)
+{
+	myTriangles.insert(myTriangles.end(), indices, indices + 3 * size);
+	return true;
+}
+
+bool
+HostOutput::addLine(const int32_t* indices, int32_t size)
+{
+	myLinePoints.insert(myLinePoints.end(), indices, indices + size);
+	myNumLines++;
+	return true;
+}
+
+bool
+HostOutput::addLines(const int32_t* indices, int32_t* sizeOfEachLine, int32_t numOfLines)
+{
+	for (int32_t i = 0; i < numOfLines; i++) {
+		addLine(indices, sizeOfEachLine[i]);
+		indices += sizeOfEachLine[i];
+	}
+	return true;
+}
+
+int32_t
+HostOutput::getNumPrimitives()
+{
+	return getNumTriangles() + myNumLines;
+}
+
+// only the points and primitives are kept
+bool HostOutput::setNormal(const Vector&, int32_t) { return true; }
+bool HostOutput::setNormals(const Vector*, int32_t, int32_t) { return true; }
+bool HostOutput::hasNormal() { return false; }
+bool HostOutput::setColor(const Color&, int32_t) { return true; }
+bool HostOutput::setColors(const Color*, int32_t, int32_t) { return true; }
+bool HostOutput::hasColor() { return false; }
+bool HostOutput::setTexCoord(const TexCoord*, int32_t, int32_t) { return true; }
+bool HostOutput::setTexCoords(const TexCoord*, int32_t, int32_t, int32_t) { return true; }
+bool HostOutput::hasTexCoord() { return false; }
+int32_t HostOutput::getNumTexCoordLayers() { return 0; }
+bool HostOutput::setCustomAttribute(const SOP_CustomAttribData*, int32_t) { return true; }
+bool HostOutput::hasCustomAttibutes() { return false; }
+bool HostOutput::addParticleSystem(int32_t, int32_t) { return true; }
+bool HostOutput::setBoundingBox(const BoundingBox&) { return true; }
+bool HostOutput::addGroup(const SOP_GroupType&, const char*) { return true; }
+bool HostOutput::destroyGroup(const SOP_GroupType&, const char*) { return true; }
+bool HostOutput::addPointToGroup(int, const char*) { return true; }
+bool HostOutput::addPrimToGroup(int, const char*) { return true; }
+bool HostOutput::addToGroup(int, const SOP_GroupType&, const char*) { return true; }
+bool HostOutput::discardFromPointGroup(int, const char*) { return true; }
+bool HostOutput::discardFromPrimGroup(int, const char*) { return true; }
+bool HostOutput::discardFromGroup(int, const SOP_GroupType&, const char*) { return true; }
+
+HostVBOOutput::HostVBOOutput() : myNumIndices(0)
+{
+}
+
+void
+HostVBOOutput::clear()
+{
+	myPositions.clear();
+	myNormals.clear();
+	myNumIndices = 0;
+}
+
+int32_t
+HostVBOOutput::getNumVertices() const
+{
+	return static_cast<int32_t>(myPositions.size());
+}
+
+int32_t
+HostVBOOutput::getNumTriangles() const
+{
+	return static_cast<int32_t>(myNumIndices / 3);
+}
+
+void
+HostVBOOutput::allocVBO(int32_t numVertices, int32_t numIndices, VBOBufferMode mode)
+{
+	myPositions.resize(numVertices);
+	myNormals.resize(numVertices);
+	myIndices.resize(numIndices);
+	myNumIndices = 0;
+}
+
+Position*
+HostVBOOutput::getPos()
+{
+	return myPositions.data();
+}
+
+Vector*
+HostVBOOutput::getNormals()
+{
+	return myNormals.data();
+}
+
+int32_t*
+HostVBOOutput::addTriangles(int32_t numTriangles)
+{
+	// like the real buffers, asking for more than allocated is a bug of the plugin
+	std::size_t start = myNumIndices;
+	myNumIndices += 3 * static_cast<std::size_t>(numTriangles);
+	if (myNumIndices > myIndices.size()) {
+		throw std::runtime_error("addTriangles past the indices given to allocVBO");
+	}
+	return myIndices.data() + start;
+}
+
+int32_t*
+HostVBOOutput::addLines(int32_t numIndices)
+{
+	std::size_t start = myNumIndices;
+	myNumIndices += numIndices;
+	if (myNumIndices > myIndices.size()) {
+		throw std::runtime_error("addLines past the indices given to allocVBO");
+	}
+	return myIndices.data() + start;
+}
+
+void HostVBOOutput::enableNormal() {}
+void HostVBOOutput::enableColor() {}
+void HostVBOOutput::enableTexCoord(int32_t) {}
+bool HostVBOOutput::hasNormal() { return true; }
+bool HostVBOOutput::hasColor() { return false; }
+bool HostVBOOutput::hasTexCoord() { return false; }
+bool HostVBOOutput::hasCustomAttibutes() { return false; }
+bool HostVBOOutput::addCustomAttribute(const SOP_CustomAttribInfo&) { return false; }
+Color* HostVBOOutput::getColors() { return nullptr; }
+TexCoord* HostVBOOutput::getTexCoords() { return nullptr; }
+int32_t HostVBOOutput::getNumTexCoordLayers() { return 0; }
+int32_t* HostVBOOutput::addParticleSystem(int32_t) { return nullptr; }
+bool HostVBOOutput::getCustomAttribute(SOP_CustomAttribData*, const char*) { return false; }
+void HostVBOOutput::updateComplete() {}
+bool HostVBOOutput::setBoundingBox(const BoundingBox&) { return true; }
+
+//-----------------------------------------------------------------------------------------------------
+//												node
+//-----------------------------------------------------------------------------------------------------
+
+HostNode::HostNode() :
+	myLibrary(nullptr),
+	myFillPluginInfo(nullptr),
+	myCreateInstance(nullptr),
+	myDestroyInstance(nullptr),
+	myInstance(nullptr),
+	myInputs(myParameters)
+{
+	memset(&myNodeInfo, 0, sizeof(myNodeInfo));
+}
+
+HostNode::~HostNode()
+{
+	if (myInstance) {
+		myDestroyInstance(myInstance);
+	}
+	if (myLibrary) {
+		dlclose(myLibrary);
+	}
+}
+
+bool
+HostNode::load(const char* pluginPath, std::string& error)
+{
+	myLibrary = dlopen(pluginPath, RTLD_NOW | RTLD_LOCAL);
+	if (!myLibrary) {
+		error = dlerror();
+		return false;
+	}
+
+	myFillPluginInfo = reinterpret_cast<FILLSOPPLUGININFO>(dlsym(myLibrary, "FillSOPPluginInfo"));
+	myCreateInstance = reinterpret_cast<CREATESOPINSTANCE>(dlsym(myLibrary, "CreateSOPInstance"));
+	myDestroyInstance = reinterpret_cast<DESTROYSOPINSTANCE>(dlsym(myLibrary, "DestroySOPInstance"));
+	if (!myFillPluginInfo || !myCreateInstance || !myDestroyInstance) {
+		error = std::string(pluginPath) + " is not a SOP plugin";
+		return false;
+	}
+
+	SOP_PluginInfo info;
+	info.customOPInfo.opType = &myOpInfoStrings[0];
+	info.customOPInfo.opLabel = &myOpInfoStrings[1];
+	info.customOPInfo.opIcon = &myOpInfoStrings[2];
+	info.customOPInfo.authorName = &myOpInfoStrings[3];
+	info.customOPInfo.authorEmail = &myOpInfoStrings[4];
+	myFillPluginInfo(&info);
+	if (info.apiVersion != SOPCPlusPlusAPIVersion) {
+		error = "the plugin was built for another version of the SOP api";
+		return false;
+	}
+	myOpType = myOpInfoStrings[0].get();
+
+	myPluginPath = pluginPath;
+	myNodeInfo.opPath = "/host/node";
+	myNodeInfo.opId = 1;
+	myNodeInfo.pluginPath = myPluginPath.c_str();
+	myInstance = myCreateInstance(&myNodeInfo);
+	if (!myInstance) {
+		error = "the plugin didn't create an instance";
+		return false;
+	}
+	myInstance->setupParameters(&myParameters, nullptr);
+	return true;
+}
+
+HostParameters&
+HostNode::getParameters()
+{
+	return myParameters;
+}
+
+HostInputs&
+HostNode::getInputs()
+{
+	return myInputs;
+}
+
+SOP_CPlusPlusBase*
+HostNode::getInstance()
+{
+	return myInstance;
+}
+
+const std::string&
+HostNode::getOpType() const
+{
+	return myOpType;
+}
+
+void
+HostNode::nextFrame()
+{
+	OP_TimeInfo& time = myInputs.getTime();
+	time.absFrame++;
+	time.frame += 1.0;
+	time.rootFrame += 1.0;
+	time.deltaFrames = 1.0;
+	time.deltaMS = 1000.0 / time.rate;
+}
+
+void
+HostNode::cook(HostOutput& output, HostVBOOutput& vboOutput, bool& directToGPU, bool& cookAgain)
+{
+	SOP_GeneralInfo info;
+	memset(&info, 0, sizeof(info));
+	myInstance->getGeneralInfo(&info, &myInputs, nullptr);
+
+	directToGPU = info.directToGPU;
+	if (directToGPU) {
+		vboOutput.clear();
+		myInstance->executeVBO(&vboOutput, &myInputs, nullptr);
+	} else {
+		output.clear();
+		myInstance->execute(&output, &myInputs, nullptr);
+	}
+
+	// what the node asks for once it has cooked decides whether the next frame cooks it
+	memset(&info, 0, sizeof(info));
+	myInstance->getGeneralInfo(&info, &myInputs, nullptr);
+	cookAgain = info.cookEveryFrame || info.cookEveryFrameIfAsked;
+}
+
+void
+HostNode::getInfoChannels(std::vector<std::pair<std::string, float>>& channels)
+{
+	channels.clear();
+	int32_t numChannels = myInstance->getNumInfoCHOPChans(nullptr);
+	for (int32_t i = 0; i < numChannels; i++) {
+		HostString name;
+		OP_InfoCHOPChan chan;
+		memset(&chan, 0, sizeof(chan));
+		chan.name = &name;
+		myInstance->getInfoCHOPChan(i, &chan, nullptr);
+		channels.emplace_back(name.get(), chan.value);
+	}
+}
+
+std::string
+HostNode::getWarning()
+{
+	HostString warning;
+	myInstance->getWarningString(&warning, nullptr);
+	return warning.get();
+}
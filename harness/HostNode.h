@@ -0,0 +1,346 @@
+#pragma once
+
+#include "SOP_CPlusPlusBase.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Stand-ins for what TouchDesigner gives to a SOP plugin, enough to load the plugin
+// outside of it and cook it on points made up by the caller.
+
+class HostString : public OP_String
+{
+public:
+
+	virtual void setString(const char* val) override;
+
+	const std::string& get() const;
+
+private:
+
+	std::string		myValue;
+};
+
+
+// Records the parameters the plugin declares with their default values,
+// which can then be changed by name.
+class HostParameters : public OP_ParameterManager
+{
+public:
+
+	struct Parameter
+	{
+		std::string					style;
+		double						values[4];
+		std::string					text;
+		std::vector<std::string>	menuNames;
+	};
+
+	// numbers are separated by commas, menus take the name of an entry.
+	// False when the plugin has no such parameter or the value doesn't fit it.
+	bool set(const std::string& name, const std::string& value);
+
+	const Parameter* find(const char* name) const;
+
+	const std::map<std::string, Parameter>& getParameters() const;
+
+	virtual OP_ParAppendResult appendFloat(const OP_NumericParameter& np, int32_t size = 1) override;
+	virtual OP_ParAppendResult appendInt(const OP_NumericParameter& np, int32_t size = 1) override;
+	virtual OP_ParAppendResult appendXY(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendXYZ(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendUV(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendUVW(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendRGB(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendRGBA(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendToggle(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendPulse(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendString(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendFile(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendFolder(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendDAT(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendCHOP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendTOP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendObject(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendMenu(const OP_StringParameter& sp, int32_t nItems,
+										  const char** names, const char** labels) override;
+	virtual OP_ParAppendResult appendStringMenu(const OP_StringParameter& sp, int32_t nItems,
+												const char** names, const char** labels) override;
+	virtual OP_ParAppendResult appendSOP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendPython(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendOP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendCOMP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendMAT(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendPanelCOMP(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendHeader(const OP_StringParameter& sp) override;
+	virtual OP_ParAppendResult appendMomentary(const OP_NumericParameter& np) override;
+	virtual OP_ParAppendResult appendWH(const OP_NumericParameter& np) override;
+
+private:
+
+	OP_ParAppendResult appendNumeric(const OP_NumericParameter& np, const char* style);
+	OP_ParAppendResult appendText(const OP_StringParameter& sp, const char* style);
+
+	std::map<std::string, Parameter>	myParameters;
+};
+
+
+// The geometry of a SOP connected to an input of the node.
+class HostSOPInput : public OP_SOPInput
+{
+public:
+
+	HostSOPInput();
+
+	HostSOPInput(const HostSOPInput&) = delete;
+	HostSOPInput& operator=(const HostSOPInput&) = delete;
+
+	std::vector<Position>& getPositions();
+
+	// every primitive is a closed polygon of the given points
+	void clearPrimitives();
+	void addPrimitive(const int32_t* points, int32_t numPoints);
+
+	// numComponents values per point
+	void clearAttributes();
+	void setIntAttribute(const char* name, int32_t numComponents, std::vector<int32_t> values);
+	void setFloatAttribute(const char* name, int32_t numComponents, std::vector<float> values);
+
+	// must be called once the geometry changed, before the next cook
+	void update();
+
+	virtual int32_t getNumPoints() const override;
+	virtual int32_t getNumVertices() const override;
+	virtual int32_t getNumPrimitives() const override;
+	virtual int32_t getNumCustomAttributes() const override;
+	virtual const Position* getPointPositions() const override;
+	virtual const SOP_NormalInfo* getNormals() const override;
+	virtual const SOP_ColorInfo* getColors() const override;
+	virtual const SOP_TextureInfo* getTextures() const override;
+	virtual const SOP_CustomAttribData* getCustomAttribute(int32_t customAttribIndex) const override;
+	virtual const SOP_CustomAttribData* getCustomAttribute(const char* customAttribName) const override;
+	virtual bool hasNormals() const override;
+	virtual bool hasColors() const override;
+	virtual bool isInside(const Position& pos) override;
+	virtual bool sendRay(const Position& pos, const Vector& dir,
+						 Position& hitPostion, float& hitLength, Vector& hitNormal,
+						 float& hitU, float& hitV, int& hitPrimitiveIndex) override;
+
+private:
+
+	struct Attribute
+	{
+		std::string				name;
+		int32_t					numComponents;
+		std::vector<int32_t>	intValues;
+		std::vector<float>		floatValues;
+	};
+
+	void setAttribute(Attribute attribute);
+
+	std::vector<Position>				myPositions;
+	std::vector<SOP_PrimitiveInfo>		myPrimitives;
+	std::vector<int32_t>				myPrimitivePoints;
+	std::vector<Attribute>				myAttributes;
+	std::vector<SOP_CustomAttribData>	myAttributeData;
+};
+
+
+class HostInputs : public OP_Inputs
+{
+public:
+
+	HostInputs(const HostParameters& parameters);
+
+	// nullptr leaves the input unconnected
+	void setInput(int32_t index, const HostSOPInput* input);
+
+	OP_TimeInfo& getTime();
+
+	virtual int32_t getNumInputs() const override;
+	virtual const OP_TOPInput* getInputTOP(int32_t index) const override;
+	virtual const OP_CHOPInput* getInputCHOP(int32_t index) const override;
+	virtual const OP_DATInput* getParDAT(const char* name) const override;
+	virtual const OP_TOPInput* getParTOP(const char* name) const override;
+	virtual const OP_CHOPInput* getParCHOP(const char* name) const override;
+	virtual const OP_ObjectInput* getParObject(const char* name) const override;
+	virtual double getParDouble(const char* name, int32_t index = 0) const override;
+	virtual bool getParDouble2(const char* name, double& v0, double& v1) const override;
+	virtual bool getParDouble3(const char* name, double& v0, double& v1, double& v2) const override;
+	virtual bool getParDouble4(const char* name, double& v0, double& v1, double& v2, double& v3) const override;
+	virtual int32_t getParInt(const char* name, int32_t index = 0) const override;
+	virtual bool getParInt2(const char* name, int32_t& v0, int32_t& v1) const override;
+	virtual bool getParInt3(const char* name, int32_t& v0, int32_t& v1, int32_t& v2) const override;
+	virtual bool getParInt4(const char* name, int32_t& v0, int32_t& v1, int32_t& v2, int32_t& v3) const override;
+	virtual const char* getParString(const char* name) const override;
+	virtual const char* getParFilePath(const char* name) const override;
+	virtual bool getRelativeTransform(const char* from, const char* to, double matrix[4][4]) const override;
+	virtual void enablePar(const char* name, bool onoff) const override;
+	virtual const OP_DATInput* getDAT(const char* path) const override;
+	virtual const OP_TOPInput* getTOP(const char* path) const override;
+	virtual const OP_CHOPInput* getCHOP(const char* path) const override;
+	virtual const OP_ObjectInput* getObject(const char* path) const override;
+	virtual void* getTOPDataInCPUMemory(const OP_TOPInput* top, const OP_TOPInputDownloadOptions* options) const override;
+	virtual const OP_SOPInput* getParSOP(const char* name) const override;
+	virtual const OP_SOPInput* getInputSOP(int32_t index) const override;
+	virtual const OP_SOPInput* getSOP(const char* path) const override;
+	virtual const OP_DATInput* getInputDAT(int32_t index) const override;
+	virtual PyObject* getParPython(const char* name) const override;
+	virtual const OP_TimeInfo* getTimeInfo() const override;
+
+private:
+
+	const HostParameters::Parameter& getParameter(const char* name) const;
+
+	const HostParameters&				myParameters;
+	std::vector<const HostSOPInput*>	myInputs;
+	OP_TimeInfo							myTime;
+};
+
+
+// Keeps the geometry the way TouchDesigner would copy it out of the plugin.
+class HostOutput : public SOP_Output
+{
+public:
+
+	HostOutput();
+
+	// empties the geometry, keeping the buffers
+	void clear();
+
+	const std::vector<Position>& getPositions() const;
+	int32_t getNumTriangles() const;
+	int32_t getNumLines() const;
+
+	virtual int32_t addPoint(const Position& pos) override;
+	virtual bool addPoints(const Position* pos, int32_t numPoints) override;
+	virtual int32_t getNumPoints() override;
+	virtual bool setNormal(const Vector& n, int32_t pointIdx) override;
+	virtual bool setNormals(const Vector* n, int32_t numPoints, int32_t startPointIdx) override;
+	virtual bool hasNormal() override;
+	virtual bool setColor(const Color& c, int32_t pointIdx) override;
+	virtual bool setColors(const Color* colors, int32_t numPoints, int32_t startPointIdx) override;
+	virtual bool hasColor() override;
+	virtual bool setTexCoord(const TexCoord* tex, int32_t numLayers, int32_t pointIdx) override;
+	virtual bool setTexCoords(const TexCoord* t, int32_t numPoints, int32_t numLayers, int32_t startPointIdx) override;
+	virtual bool hasTexCoord() override;
+	virtual int32_t getNumTexCoordLayers() override;
+	virtual bool setCustomAttribute(const SOP_CustomAttribData* cu, int32_t numPoints) override;
+	virtual bool hasCustomAttibutes() override;
+	virtual bool addTriangle(int32_t ptIdx1, int32_t ptIdx2, int32_t ptIdx3) override;
+	virtual bool addTriangles(const int32_t* indices, int32_t size) override;
+	virtual bool addParticleSystem(int32_t numParticles, int32_t startIndex) override;
+	virtual bool addLine(const int32_t* indices, int32_t size) override;
+	virtual bool addLines(const int32_t* indices, int32_t* sizeOfEachLine, int32_t numOfLines) override;
+	virtual int32_t getNumPrimitives() override;
+	virtual bool setBoundingBox(const BoundingBox& bbox) override;
+	virtual bool addGroup(const SOP_GroupType& type, const char* name) override;
+	virtual bool destroyGroup(const SOP_GroupType& type, const char* name) override;
+	virtual bool addPointToGroup(int index, const char* name) override;
+	virtual bool addPrimToGroup(int index, const char* name) override;
+	virtual bool addToGroup(int index, const SOP_GroupType& type, const char* name) override;
+	virtual bool discardFromPointGroup(int index, const char* name) override;
+	virtual bool discardFromPrimGroup(int index, const char* name) override;
+	virtual bool discardFromGroup(int index, const SOP_GroupType& type, const char* name) override;
+
+private:
+
+	std::vector<Position>	myPositions;
+	std::vector<int32_t>	myTriangles;
+	std::vector<int32_t>	myLinePoints;
+	int32_t					myNumLines;
+};
+
+
+class HostVBOOutput : public SOP_VBOOutput
+{
+public:
+
+	HostVBOOutput();
+
+	void clear();
+
+	int32_t getNumVertices() const;
+	int32_t getNumTriangles() const;
+
+	virtual void enableNormal() override;
+	virtual void enableColor() override;
+	virtual void enableTexCoord(int32_t numLayers = 0) override;
+	virtual bool hasNormal() override;
+	virtual bool hasColor() override;
+	virtual bool hasTexCoord() override;
+	virtual bool hasCustomAttibutes() override;
+	virtual bool addCustomAttribute(const SOP_CustomAttribInfo& cu) override;
+	virtual void allocVBO(int32_t numVertices, int32_t numIndices, VBOBufferMode mode) override;
+	virtual Position* getPos() override;
+	virtual Vector* getNormals() override;
+	virtual Color* getColors() override;
+	virtual TexCoord* getTexCoords() override;
+	virtual int32_t getNumTexCoordLayers() override;
+	virtual int32_t* addTriangles(int32_t numTriangles) override;
+	virtual int32_t* addParticleSystem(int32_t numParticles) override;
+	virtual int32_t* addLines(int32_t numIndices) override;
+	virtual bool getCustomAttribute(SOP_CustomAttribData* cu, const char* name) override;
+	virtual void updateComplete() override;
+	virtual bool setBoundingBox(const BoundingBox& bbox) override;
+
+private:
+
+	std::vector<Position>	myPositions;
+	std::vector<Vector>		myNormals;
+	std::vector<int32_t>	myIndices;
+	std::size_t				myNumIndices;
+};
+
+
+// The plugin loaded from its shared object, and one node of it.
+class HostNode
+{
+public:
+
+	HostNode();
+
+	~HostNode();
+
+	HostNode(const HostNode&) = delete;
+	HostNode& operator=(const HostNode&) = delete;
+
+	// loads the plugin and creates the node, error tells why it failed
+	bool load(const char* pluginPath, std::string& error);
+
+	HostParameters& getParameters();
+	HostInputs& getInputs();
+	SOP_CPlusPlusBase* getInstance();
+	const std::string& getOpType() const;
+
+	// moves the time of the inputs one frame forward
+	void nextFrame();
+
+	// one cook at the time of the inputs, through execute or executeVBO like the plugin asks
+	// in getGeneralInfo. cookAgain is set when it then asks to cook every frame, an
+	// output always being looked at.
+	void cook(HostOutput& output, HostVBOOutput& vboOutput, bool& directToGPU, bool& cookAgain);
+
+	void getInfoChannels(std::vector<std::pair<std::string, float>>& channels);
+	std::string getWarning();
+
+private:
+
+	void*						myLibrary;
+	FILLSOPPLUGININFO			myFillPluginInfo;
+	CREATESOPINSTANCE			myCreateInstance;
+	DESTROYSOPINSTANCE			myDestroyInstance;
+
+	HostString					myOpInfoStrings[5];
+	std::string					myOpType;
+	std::string					myPluginPath;
+
+	OP_NodeInfo					myNodeInfo;
+	SOP_CPlusPlusBase*			myInstance;
+	HostParameters				myParameters;
+	HostInputs					myInputs;
+};
@@ -0,0 +1,333 @@
+// Cooks the plugin again with the cooks recorded by its Capture parameters, at the
+// recorded time and with the recorded parameters and inputs, and prints the timings
+// of every cook, one JSON object per line.
+//
+//	sopreplay [--plugin path] [--passes n] capture
+
+#include "Allocations.h"
+#include "HostNode.h"
+#include "CookCapture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		std::string		pluginPath = "./DelaunayTriangulationSop.so";
+		std::string		capturePath;
+		int32_t			numPasses = 1;
+	};
+
+	bool
+	parseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (strcmp(arg, "--plugin") == 0 && hasValue) {
+				options.pluginPath = argv[++i];
+			} else if (strcmp(arg, "--passes") == 0 && hasValue) {
+				options.numPasses = std::max(1, atoi(argv[++i]));
+			} else if (arg[0] != '-' && options.capturePath.empty()) {
+				options.capturePath = arg;
+			} else {
+				options.capturePath.clear();
+				break;
+			}
+		}
+		if (options.capturePath.empty()) {
+			fprintf(stderr, "usage: %s [--plugin path] [--passes n] capture\n", argv[0]);
+			return false;
+		}
+		return true;
+	}
+
+	// reads the file written by CookCapture, see CookCapture.h
+	class CaptureReader
+	{
+	public:
+
+		CaptureReader() : myFile(nullptr)
+		{
+		}
+
+		~CaptureReader()
+		{
+			if (myFile) {
+				fclose(myFile);
+			}
+		}
+
+		bool
+		open(const char* path, std::string& error)
+		{
+			myFile = fopen(path, "rb");
+			if (!myFile) {
+				error = std::string("can't open ") + path;
+				return false;
+			}
+			uint32_t magic = 0;
+			uint32_t version = 0;
+			if (!read(magic) || !read(version) || magic != CookCapture::Magic) {
+				error = std::string(path) + " is not a capture";
+				return false;
+			}
+			if (version != CookCapture::Version) {
+				error = std::string(path) + " is a capture of another version";
+				return false;
+			}
+			return true;
+		}
+
+		// false at the end of the file, error is set when it ends in the middle of a cook
+		bool
+		readCook(HostNode& node, std::vector<std::unique_ptr<HostSOPInput>>& inputs, std::string& error)
+		{
+			OP_TimeInfo& time = node.getInputs().getTime();
+			if (!read(time.absFrame)) {
+				return false;
+			}
+			error = "the capture ends in the middle of a cook";
+			if (!read(time.frame) || !read(time.rate) || !read(time.rootFrame) || !read(time.rootRate) ||
+				!read(time.deltaFrames) || !read(time.deltaMS)) {
+				return false;
+			}
+
+			uint32_t numParameters = 0;
+			if (!read(numParameters)) {
+				return false;
+			}
+			for (uint32_t i = 0; i < numParameters; i++) {
+				std::string name;
+				CookCapture::ParameterType type;
+				std::string value;
+				if (!readText(name) || !read(type)) {
+					return false;
+				}
+				if (type == CookCapture::ParameterType::numeric) {
+					uint32_t numValues = 0;
+					if (!read(numValues)) {
+						return false;
+					}
+					for (uint32_t j = 0; j < numValues; j++) {
+						double number = 0.0;
+						if (!read(number)) {
+							return false;
+						}
+						char text[32];
+						snprintf(text, sizeof(text), "%s%.17g", j ? "," : "", number);
+						value += text;
+					}
+				} else if (!readText(value)) {
+					return false;
+				}
+
+				// a parameter renamed or removed since the capture keeps its default
+				if (!node.getParameters().set(name, value) && myMissingParameters.insert(name).second) {
+					fprintf(stderr, "the plugin has no parameter %s=%s, it is left as is\n", name.c_str(), value.c_str());
+				}
+			}
+
+			uint32_t numInputs = 0;
+			if (!read(numInputs)) {
+				return false;
+			}
+			while (inputs.size() < numInputs) {
+				inputs.emplace_back(new HostSOPInput());
+			}
+			for (uint32_t i = 0; i < numInputs; i++) {
+				uint8_t changed = 0;
+				if (!read(changed) || (changed && !readInput(*inputs[i]))) {
+					return false;
+				}
+				node.getInputs().setInput(i, inputs[i].get());
+			}
+			for (std::size_t i = numInputs; i < inputs.size(); i++) {
+				node.getInputs().setInput(static_cast<int32_t>(i), nullptr);
+			}
+
+			error.clear();
+			return true;
+		}
+
+	private:
+
+		bool
+		read(void* data, std::size_t size)
+		{
+			return fread(data, 1, size, myFile) == size;
+		}
+
+		template <typename T>
+		bool
+		read(T& value)
+		{
+			return read(&value, sizeof(T));
+		}
+
+		bool
+		readText(std::string& text)
+		{
+			uint32_t length = 0;
+			if (!read(length)) {
+				return false;
+			}
+			text.resize(length);
+			return read(&text[0], length);
+		}
+
+		bool
+		readInput(HostSOPInput& input)
+		{
+			uint32_t numPoints = 0;
+			if (!read(numPoints)) {
+				return false;
+			}
+			std::vector<Position>& positions = input.getPositions();
+			positions.resize(numPoints);
+			if (!read(positions.data(), numPoints * sizeof(Position))) {
+				return false;
+			}
+
+			uint32_t numPrimitives = 0;
+			if (!read(numPrimitives)) {
+				return false;
+			}
+			myNumVertices.resize(numPrimitives);
+			if (!read(myNumVertices.data(), numPrimitives * sizeof(int32_t))) {
+				return false;
+			}
+			std::size_t numIndices = 0;
+			for (int32_t numVertices : myNumVertices) {
+				numIndices += numVertices;
+			}
+			myPointIndices.resize(numIndices);
+			if (!read(myPointIndices.data(), numIndices * sizeof(int32_t))) {
+				return false;
+			}
+			input.clearPrimitives();
+			const int32_t* points = myPointIndices.data();
+			for (int32_t numVertices : myNumVertices) {
+				input.addPrimitive(points, numVertices);
+				points += numVertices;
+			}
+
+			uint32_t numAttributes = 0;
+			if (!read(numAttributes)) {
+				return false;
+			}
+			input.clearAttributes();
+			for (uint32_t i = 0; i < numAttributes; i++) {
+				std::string name;
+				uint8_t type = 0;
+				int32_t numComponents = 0;
+				if (!readText(name) || !read(type) || !read(numComponents) || numComponents < 0) {
+					return false;
+				}
+				const std::size_t numValues = static_cast<std::size_t>(numPoints) * numComponents;
+				if (static_cast<AttribType>(type) == AttribType::Int) {
+					std::vector<int32_t> values(numValues);
+					if (!read(values.data(), numValues * sizeof(int32_t))) {
+						return false;
+					}
+					input.setIntAttribute(name.c_str(), numComponents, std::move(values));
+				} else {
+					std::vector<float> values(numValues);
+					if (!read(values.data(), numValues * sizeof(float))) {
+						return false;
+					}
+					input.setFloatAttribute(name.c_str(), numComponents, std::move(values));
+				}
+			}
+
+			input.update();
+			return true;
+		}
+
+		FILE*					myFile;
+		std::vector<int32_t>	myNumVertices;
+		std::vector<int32_t>	myPointIndices;
+		std::set<std::string>	myMissingParameters;
+	};
+}
+
+int
+main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return 2;
+	}
+
+	for (int32_t pass = 0; pass < options.numPasses; pass++) {
+		// every pass starts from a new node, like the recorded one nothing is cached
+		HostNode node;
+		std::string error;
+		if (!node.load(options.pluginPath.c_str(), error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		CaptureReader reader;
+		if (!reader.open(options.capturePath.c_str(), error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+
+		std::vector<std::unique_ptr<HostSOPInput>> inputs;
+		HostOutput output;
+		HostVBOOutput vboOutput;
+		std::vector<std::pair<std::string, float>> channels;
+		std::vector<double> times;
+
+		for (int32_t cook = 0; reader.readCook(node, inputs, error); cook++) {
+			const uint64_t numAllocations = getNumAllocations();
+			const uint64_t allocatedBytes = getAllocatedBytes();
+			bool directToGPU = false;
+			bool cookAgain = false;
+
+			const auto start = std::chrono::steady_clock::now();
+			node.cook(output, vboOutput, directToGPU, cookAgain);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			times.push_back(ms);
+
+			const int32_t numPoints = inputs.empty() ? 0 : static_cast<int32_t>(inputs[0]->getPositions().size());
+			node.getInfoChannels(channels);
+			printf("{\"type\":\"cook\",\"pass\":%d,\"cook\":%d,\"abs_frame\":%lld,\"points\":%d,\"cook_ms\":%.4f,"
+				   "\"allocations\":%llu,\"allocated_bytes\":%llu,\"gpu\":%s,\"output_points\":%d,\"output_triangles\":%d",
+				   pass, cook, static_cast<long long>(node.getInputs().getTime().absFrame), numPoints, ms,
+				   static_cast<unsigned long long>(getNumAllocations() - numAllocations),
+				   static_cast<unsigned long long>(getAllocatedBytes() - allocatedBytes),
+				   directToGPU ? "true" : "false",
+				   directToGPU ? vboOutput.getNumVertices() : static_cast<int32_t>(output.getPositions().size()),
+				   directToGPU ? vboOutput.getNumTriangles() : output.getNumTriangles());
+			printf(",\"info\":{");
+			for (std::size_t c = 0; c < channels.size(); c++) {
+				printf("%s\"%s\":%.9g", c ? "," : "", channels[c].first.c_str(), channels[c].second);
+			}
+			printf("}}\n");
+		}
+		if (!error.empty()) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+
+		double total = 0.0;
+		for (double time : times) {
+			total += time;
+		}
+		std::sort(times.begin(), times.end());
+		printf("{\"type\":\"summary\",\"pass\":%d,\"cooks\":%zu,\"total_ms\":%.4f,\"median_ms\":%.4f,\"max_ms\":%.4f}\n",
+			   pass, times.size(), total, times.empty() ? 0.0 : times[times.size() / 2], times.empty() ? 0.0 : times.back());
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// CPlusPlus_Common.h includes the OpenGL types of macOS outside of Windows,
+// the plugin doesn't use them so the headless host only needs the names.
+#include <stdint.h>
+
+typedef unsigned int	GLuint;
+typedef int				GLint;
+typedef unsigned int	GLenum;
+typedef float			GLfloat;